@@ -8,16 +8,23 @@
 #include "univalue.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <cinttypes>
 #include <cstdlib>
 #include <cstdio>
 #include <cstring>
+#include <iomanip>
 #include <iostream>
+#include <locale>
+#include <new>
+#include <optional>
+#include <sstream>
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <vector>
 
 #ifdef _WIN32
 // The below are only used by GetPerfTimeNanos() in the Windows case
@@ -42,6 +49,40 @@
 #undef HAVE_YYJSON
 #endif
 
+namespace {
+/// Total number of calls to the global operator new (see the replacement operators below), so that we may report
+/// the number of heap allocations done per parse.
+std::atomic<uint64_t> allocCount{0};
+} // namespace
+
+void *operator new(std::size_t size) {
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+// (GCC's -Wmismatched-new-delete cannot tell that the operator new it inlines into callers is this malloc() one)
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+// std::pmr::new_delete_resource() allocates via the aligned forms
+void *operator new(std::size_t size, std::align_val_t align) {
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    const size_t a = static_cast<size_t>(align);
+    if (void *p = a <= alignof(std::max_align_t) ? std::malloc(size ? size : 1)
+                                                 : std::aligned_alloc(a, (std::max<size_t>(size, 1) + a - 1) / a * a))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
 namespace {
 
 int64_t GetPerfTimeNanos() {
@@ -161,7 +202,8 @@ public:
     ~Defer() { f(); }
 };
 
-void printResults(const Tic &t0, std::vector<Tic> &parseTimes, std::vector<Tic> &serializeTimes)
+void printResults(const Tic &t0, std::vector<Tic> &parseTimes, std::vector<Tic> &serializeTimes, size_t nBytes,
+                  std::optional<uint64_t> parseAllocs = std::nullopt)
 {
     assert(!parseTimes.empty() && !serializeTimes.empty());
     const auto Compare = [](const Tic &a, const Tic &b){ return a.nsec() < b.nsec(); };
@@ -186,27 +228,69 @@ void printResults(const Tic &t0, std::vector<Tic> &parseTimes, std::vector<Tic>
               << "median: " << serializeMedian.msecStr()
               << ", avg: " << Tic::format(serializeAvg/1e3, 3)
               << ", best: " << serializeTimes.front().msecStr()
-              << ", worst: " << serializeTimes.back().msecStr() << "\n";
+              << ", worst: " << serializeTimes.back().msecStr() << "\n"
+              << "Parse throughput (MB/sec) - median: "
+              << Tic::format(nBytes / 1e6 / std::max(parseMedian.secs(), 1e-9), 1) << "\n";
+    if (parseAllocs) // only known for C++ libs, which allocate via operator new
+        std::cout << "Parse heap allocations - " << *parseAllocs / N << " per parse\n";
 }
 
+/// How runbench_univalue() reads the document
+enum class UniValueMode {
+    Read,         ///< UniValue::read() into a fresh UniValue
+    Document,     ///< UniValue::Document::read(), i.e. into an arena
+    ReadInPlace,  ///< UniValue::readInPlace() over the value of the previous iteration
+    StreamReader, ///< UniValue::StreamReader, fed in chunks of streamChunkSize bytes
+    ReadParallel, ///< UniValue::readParallel() into a fresh UniValue, on as many threads as there are CPU cores
+    ReadFile,     ///< UniValue::readFile() of the file the document came from, into a fresh UniValue
+};
+
+constexpr size_t streamChunkSize = 64 * 1024; // typical of a socket receive buffer
+
 [[nodiscard]]
-bool runbench_univalue(const size_t N, const std::string &jdata)
+bool runbench_univalue(const size_t N, const std::string &jdata,
+                       const UniValue::ReadEngine engine = UniValue::ReadEngine::Default,
+                       const UniValueMode mode = UniValueMode::Read, const std::string &path = {})
 {
     assert(N > 0);
     std::cout << "Parsing and re-serializing " << N << " times ...\n";
-    std::vector<Tic> parseTimes, serializeTimes;
-    parseTimes.reserve(N); serializeTimes.reserve(N);
+    std::vector<Tic> parseTimes, serializeTimes, freeTimes;
+    parseTimes.reserve(N); serializeTimes.reserve(N); freeTimes.reserve(N);
     std::vector<std::string> strings;
     strings.reserve(2);
+    uint64_t parseAllocs = 0;
+    UniValue::Document doc;
+    UniValue::StreamReader reader;
+    UniValue recycled; // for ReadInPlace, each parse recycles the tree of the previous one
+    const auto parse = [&](UniValue &uv) {
+        switch (mode) {
+        case UniValueMode::Read: return uv.read(jdata, nullptr, engine);
+        case UniValueMode::Document: return doc.read(jdata, nullptr, engine);
+        case UniValueMode::ReadInPlace: return uv.readInPlace(jdata, nullptr, engine);
+        case UniValueMode::ReadParallel: return uv.readParallel(jdata);
+        case UniValueMode::ReadFile: return uv.readFile(path, nullptr, engine);
+        case UniValueMode::StreamReader:
+            for (size_t pos = 0; pos < jdata.size(); pos += streamChunkSize)
+                if (!reader.feed(jdata.data() + pos, std::min(streamChunkSize, jdata.size() - pos)))
+                    return false;
+            return reader.finish();
+        }
+        return false;
+    };
     Tic t0;
     for (size_t i = 0; i < N; ++i) {
-        UniValue uv;
+        UniValue local;
+        UniValue &uv = mode == UniValueMode::Document ? doc.root()
+                       : mode == UniValueMode::ReadInPlace ? recycled
+                       : mode == UniValueMode::StreamReader ? reader.root() : local;
 
         parseTimes.emplace_back(); // start timer
-        if ( ! uv.read(jdata)) {
+        const uint64_t allocs0 = allocCount.load(std::memory_order_relaxed);
+        if ( ! parse(uv)) {
             std::cout << "Failed to parse on iteration " << i << "!\n";
             return false;
         }
+        parseAllocs += allocCount.load(std::memory_order_relaxed) - allocs0;
         parseTimes.back().fin(); // freeze timer
 
         serializeTimes.emplace_back(); // start timer
@@ -216,14 +300,66 @@ bool runbench_univalue(const size_t N, const std::string &jdata)
         // check strings -- this is to ensure uv.stringify() is not a no-op above
         assert(strings.size() < 2 || strings[strings.size() - 1] == strings[strings.size() - 2]);
         strings.resize(1); // throw away old strings
+
+        freeTimes.emplace_back(); // start timer
+        if (mode == UniValueMode::Document)
+            doc.clear();
+        else if (mode == UniValueMode::StreamReader)
+            reader.reset();
+        else if (mode != UniValueMode::ReadInPlace)
+            uv.setNull();
+        freeTimes.back().fin(); // freeze timer
     }
     t0.fin();
 
-    printResults(t0, parseTimes, serializeTimes);
+    printResults(t0, parseTimes, serializeTimes, jdata.size(), parseAllocs);
+    std::sort(freeTimes.begin(), freeTimes.end(), [](const Tic &a, const Tic &b){ return a.nsec() < b.nsec(); });
+    std::cout << "Free (msec) - median: " << freeTimes[N / 2].msecStr() << "\n";
 
     return true;
 }
 
+/// Benchmarks `parse(jdata)`, which does not build a UniValue tree (so there is nothing to serialize)
+template <typename Parse>
+[[nodiscard]]
+bool runbench_univalue_parse_only(const size_t N, const std::string &jdata, Parse &&parse)
+{
+    assert(N > 0);
+    std::cout << "Parsing " << N << " times ...\n";
+    std::vector<Tic> parseTimes;
+    parseTimes.reserve(N);
+    uint64_t parseAllocs = 0;
+    for (size_t i = 0; i < N; ++i) {
+        parseTimes.emplace_back(); // start timer
+        const uint64_t allocs0 = allocCount.load(std::memory_order_relaxed);
+        if ( ! parse(jdata)) {
+            std::cout << "Failed to parse on iteration " << i << "!\n";
+            return false;
+        }
+        parseAllocs += allocCount.load(std::memory_order_relaxed) - allocs0;
+        parseTimes.back().fin(); // freeze timer
+    }
+    std::sort(parseTimes.begin(), parseTimes.end(), [](const Tic &a, const Tic &b){ return a.nsec() < b.nsec(); });
+    const auto &parseMedian = parseTimes[N / 2];
+    std::cout << "Parse (msec) - median: " << parseMedian.msecStr() << ", best: " << parseTimes.front().msecStr()
+              << ", worst: " << parseTimes.back().msecStr() << "\n"
+              << "Parse throughput (MB/sec) - median: "
+              << Tic::format(jdata.size() / 1e6 / std::max(parseMedian.secs(), 1e-9), 1) << "\n"
+              << "Parse heap allocations - " << parseAllocs / N << " per parse\n";
+    return true;
+}
+
+/// A SAX handler that merely counts the values
+struct CountValues : UniValue::SaxHandler {
+    size_t count = 0;
+    bool onNull() override { ++count; return true; }
+    bool onBool(bool) override { ++count; return true; }
+    bool onNumber(std::string_view) override { ++count; return true; }
+    bool onString(std::string_view) override { ++count; return true; }
+    bool onStartObject() override { ++count; return true; }
+    bool onStartArray() override { ++count; return true; }
+};
+
 #ifdef HAVE_NLOHMANN
 void runbench_nlohmann(const size_t N, const std::string &jdata)
 {
@@ -233,10 +369,13 @@ void runbench_nlohmann(const size_t N, const std::string &jdata)
     parseTimes.reserve(N); serializeTimes.reserve(N);
     std::vector<std::string> strings;
     strings.reserve(2);
+    uint64_t parseAllocs = 0;
     Tic t0;
     for (size_t i = 0; i < N; ++i) {
         parseTimes.emplace_back(); // start timer
+        const uint64_t allocs0 = allocCount.load(std::memory_order_relaxed);
         auto j = nlohmann::json::parse(jdata); // this throws on parse error
+        parseAllocs += allocCount.load(std::memory_order_relaxed) - allocs0;
         parseTimes.back().fin(); // freeze timer
 
         serializeTimes.emplace_back(); // start timer
@@ -249,7 +388,7 @@ void runbench_nlohmann(const size_t N, const std::string &jdata)
     }
     t0.fin();
 
-    printResults(t0, parseTimes, serializeTimes);
+    printResults(t0, parseTimes, serializeTimes, jdata.size(), parseAllocs);
 }
 #endif
 
@@ -301,7 +440,7 @@ bool runbench_jansson(const size_t N, const std::string &jdata)
     }
     t0.fin();
 
-    printResults(t0, parseTimes, serializeTimes);
+    printResults(t0, parseTimes, serializeTimes, jdata.size());
 
     return true;
 }
@@ -352,7 +491,7 @@ bool runbench_yyjson(const size_t N, const std::string &jdata)
     }
     t0.fin();
 
-    printResults(t0, parseTimes, serializeTimes);
+    printResults(t0, parseTimes, serializeTimes, jdata.size());
 
     return true;
 }
@@ -360,32 +499,79 @@ bool runbench_yyjson(const size_t N, const std::string &jdata)
 
 bool runbench_file(const std::string &path)
 {
-    std::string jdata;
+    std::string jdata; // a copy is kept, as the other libraries need a NUL-terminated string
     {
         const Tic tread0;
-        FILE *f = std::fopen(path.c_str(), "r");
-        assert(f != nullptr);
-
-
-        char buf[16384];
-        while (!std::feof(f)) {
-            const int bread = std::fread(buf, 1, sizeof(buf), f);
-            assert(!std::ferror(f));
-            assert(bread >= 0);
-
-            std::string_view s(buf, bread);
-            jdata += s;
-        }
-
-        assert(!std::ferror(f));
-        std::fclose(f);
+        const UniValue::MappedFile file(path);
+        jdata = file.view();
         std::cout << "Read " << jdata.size() << " bytes in " << tread0.msecStr() << " msec\n";
     }
 
     constexpr size_t N = 10;
-    std::cout << "\n--- UniValue lib ---\n";
-    if ( ! runbench_univalue(N, jdata))
+    // Bench UniValue once for each of the kernel implementations supported by this CPU, best (the default) first
+    const std::string defaultImpl = UniValue::simdImplementation();
+    const Defer restoreImpl([&defaultImpl]{ UniValue::setSimdImplementation(defaultImpl); });
+    for (const auto &impl : UniValue::simdImplementations()) {
+        UniValue::setSimdImplementation(impl);
+        std::cout << "\n--- UniValue lib (kernels: " << impl << ") ---\n";
+        if ( ! runbench_univalue(N, jdata))
+            return false;
+    }
+    UniValue::setSimdImplementation(defaultImpl);
+    for (const auto &[engine, name] : {std::pair{UniValue::ReadEngine::Tokenizer, "tokenizer"},
+                                       std::pair{UniValue::ReadEngine::StructuralIndex, "structural index"}}) {
+        std::cout << "\n--- UniValue lib (kernels: " << defaultImpl << ", read engine: " << name << ") ---\n";
+        if ( ! runbench_univalue(N, jdata, engine))
+            return false;
+    }
+    for (const auto &[mode, name] : {std::pair{UniValueMode::Document, "arena Document"},
+                                     std::pair{UniValueMode::ReadInPlace, "readInPlace"},
+                                     std::pair{UniValueMode::StreamReader, "StreamReader, 64 KiB chunks"},
+                                     std::pair{UniValueMode::ReadParallel, "readParallel"},
+                                     std::pair{UniValueMode::ReadFile, "readFile, from the mapped file"}}) {
+        std::cout << "\n--- UniValue lib (kernels: " << defaultImpl << ", " << name << ") ---\n";
+        if ( ! runbench_univalue(N, jdata, UniValue::ReadEngine::Default, mode, path))
+            return false;
+    }
+    std::cout << "\n--- UniValue lib (kernels: " << defaultImpl << ", validate, no tree) ---\n";
+    if ( ! runbench_univalue_parse_only(N, jdata, [](const std::string &json) { return UniValue::validate(json); }))
+        return false;
+    std::cout << "\n--- UniValue lib (kernels: " << defaultImpl << ", readSax, no tree) ---\n";
+    if ( ! runbench_univalue_parse_only(N, jdata, [](const std::string &json) {
+            CountValues handler;
+            return UniValue::readSax(json, handler) && handler.count > 0;
+        }))
         return false;
+    {
+        std::cout << "\n--- UniValue lib (kernels: " << defaultImpl << ", LazyDocument, index only) ---\n";
+        UniValue::LazyDocument lazy;
+        if ( ! runbench_univalue_parse_only(N, jdata, [&lazy](const std::string &json) { return lazy.read(json); }))
+            return false;
+    }
+    {
+        // for a block such as block556034.json, just its height and txids; for anything else, all of it is skipped
+        std::cout << "\n--- UniValue lib (kernels: " << defaultImpl << ", readFiltered, /height and /tx) ---\n";
+        const UniValue::PathFilter filter{"/height", "/tx"};
+        if ( ! runbench_univalue_parse_only(N, jdata, [&filter](const std::string &json) {
+                UniValue uv;
+                return uv.readFiltered(json, filter);
+            }))
+            return false;
+    }
+    if (UniValue root; root.read(jdata) && root.isArray() && !root.empty()) {
+        // the elements of a top-level array, as newline-delimited JSON
+        std::cout << "\n--- UniValue lib (kernels: " << defaultImpl << ", NDJSON of the top-level elements) ---\n";
+        Tic twrite;
+        const std::string ndjson = UniValue::writeLines(root.get_array());
+        twrite.fin();
+        std::cout << "writeLines (msec) - " << twrite.msecStr() << "\n";
+        if ( ! runbench_univalue_parse_only(N, ndjson, [&root](const std::string &json) {
+                size_t count = 0;
+                return UniValue::readLines(json, [&count](size_t, UniValue &&) { ++count; return true; })
+                       && count == root.size();
+            }))
+            return false;
+    }
 #ifdef HAVE_NLOHMANN
     std::cout << "\n--- nlohmann::json lib ---\n";
     try {
@@ -408,6 +594,201 @@ bool runbench_file(const std::string &path)
     return true;
 }
 
+/// Runs `func`, which processes `count` numbers, N times, and prints the median and best time per number.
+template <typename Func>
+[[nodiscard]]
+bool runbench_number(const char *what, const size_t N, const size_t count, Func &&func)
+{
+    std::vector<Tic> times;
+    for (size_t i = 0; i < N; ++i) {
+        Tic t;
+        if (!func()) {
+            std::cout << what << ": failed on iteration " << i << "!\n";
+            return false;
+        }
+        t.fin();
+        times.push_back(t);
+    }
+    std::sort(times.begin(), times.end(), [](const Tic &a, const Tic &b){ return a.nsec() < b.nsec(); });
+    std::cout << what << " (nsec per number) - median: " << Tic::format(times[N / 2].nsec() / double(count), 2)
+              << ", best: " << Tic::format(times.front().nsec() / double(count), 2) << "\n";
+    return true;
+}
+
+/// What UniValue::get_real() did before it had its own parser, for comparison: parse with a std::istringstream.
+bool LegacyParseDouble(const std::string &str, double *out)
+{
+    std::istringstream text(str);
+    text.imbue(std::locale::classic());
+    text >> *out;
+    return text.eof() && !text.fail();
+}
+
+[[nodiscard]]
+bool runbench_numbers()
+{
+    constexpr size_t N = 11, count = 1'000'000;
+    std::cout << std::string(80, '-') << "\n"
+              << "Running number benchmarks (" << count << " numbers per run) ...\n";
+    // Integers of all lengths and both signs, such as amounts, heights and sizes
+    std::vector<int64_t> ints(count);
+    uint64_t x = 42;
+    for (size_t i = 0; i < count; ++i) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        ints[i] = int64_t(x >> (1 + i % 63)) * (i % 7 ? 1 : -1);
+    }
+
+    std::cout << "\n--- UniValue lib (integers: assigned as an RPC response does, and read back from JSON) ---\n";
+    UniValue arr;
+    bool ok = runbench_number("Assign", N, count, [&] {
+        auto &a = arr.setArray();
+        a.reserve(count);
+        for (const auto i : ints)
+            a.emplace_back(i);
+        return a.size() == count;
+    });
+    std::string json;
+    ok = ok && runbench_number("Stringify", N, count, [&] {
+        json = UniValue::stringify(arr);
+        return json.size() > count;
+    });
+
+    // The integer getters, on integers read from JSON (i.e. held as text): each in its own range
+    const auto ReadInts = [&](auto convert) {
+        std::string text = "[";
+        for (const auto i : ints)
+            text += std::to_string(convert(i)) + ",";
+        text.back() = ']';
+        UniValue v;
+        const bool readOk = v.read(text);
+        assert(readOk);
+        return v;
+    };
+    const auto BenchGetter = [&](const char *what, const UniValue &values, auto get) {
+        int64_t total = 0;
+        return runbench_number(what, N, count, [&] {
+            for (const auto &v : values.get_array())
+                total += int64_t(get(v));
+            return true;
+        });
+    };
+    ok = ok && BenchGetter("get_int()", ReadInts([](int64_t i) { return int32_t(i); }),
+                           [](const UniValue &v) { return v.get_int(); });
+    const UniValue int64s = ReadInts([](int64_t i) { return i; });
+    ok = ok && BenchGetter("get_int64()", int64s, [](const UniValue &v) { return v.get_int64(); });
+    std::vector<int64_t> int64Vector(count);
+    ok = ok && runbench_number("Array::to_numbers(), int64_t", N, count, [&] {
+        return int64s.get_array().to_numbers(int64Vector.data(), count) == count && int64Vector == ints;
+    });
+    ok = ok && BenchGetter("get_uint64()", ReadInts([](int64_t i) { return uint64_t(i); }),
+                           [](const UniValue &v) { return v.get_uint64(); });
+
+    // Doubles as text, as in a mempool dump: half are amounts with 8 decimals, half need all 17 digits
+    std::cout << "\n--- UniValue lib (doubles, as read from JSON) ---\n";
+    std::string doublesJson = "[";
+    for (size_t i = 0; i < count; ++i) {
+        char buf[40];
+        const auto frac = double(uint64_t(ints[i]) % 1'000'000'007) / 1'000'000'007.0;
+        if (i % 2)
+            std::snprintf(buf, sizeof(buf), "%.8f,", double(uint64_t(ints[i]) % 100'000'000) / 1e8 * 50);
+        else
+            std::snprintf(buf, sizeof(buf), "%.17g,", frac * 1000);
+        doublesJson += buf;
+    }
+    doublesJson.back() = ']';
+    UniValue doubles;
+    ok = ok && doubles.read(doublesJson);
+    double sum = 0;
+    ok = ok && runbench_number("get_real(), istringstream (before)", N, count, [&] {
+        for (const auto &v : doubles.get_array()) {
+            double d;
+            if (!LegacyParseDouble(v.getValStr(), &d))
+                return false;
+            sum += d;
+        }
+        return true;
+    });
+    const double legacySum = sum;
+    sum = 0;
+    ok = ok && runbench_number("get_real()", N, count, [&] {
+        for (const auto &v : doubles.get_array())
+            sum += v.get_real();
+        return true;
+    });
+    ok = ok && sum == legacySum;
+    ok = ok && runbench_number("Array::to_vector<double>()", N, count, [&] {
+        const auto reals = doubles.get_array().to_vector<double>();
+        return reals.size() == count && reals.back() == doubles.get_array().back().get_real();
+    });
+
+    // The same doubles, as an RPC response builds them
+    std::vector<double> reals;
+    reals.reserve(count);
+    for (const auto &v : doubles.get_array())
+        reals.push_back(v.get_real());
+    ok = ok && runbench_number("Format, ostringstream with 16 digits (before)", N, count, [&] {
+        json.clear();
+        for (const double d : reals) {
+            std::ostringstream oss;
+            oss.imbue(std::locale::classic());
+            oss << std::setprecision(16) << d;
+            json += oss.str();
+        }
+        return json.size() > count;
+    });
+    for (const auto &[format, name] : {std::pair{UniValue::RealFormat::Shortest, "shortest"},
+                                       std::pair{UniValue::RealFormat::Legacy16, "16 digits"}}) {
+        const std::string what = std::string("Assign and stringify, ") + name;
+        ok = ok && runbench_number(what.c_str(), N, count, [&, format = format] {
+            auto &a = arr.setArray();
+            a.reserve(count);
+            for (const double d : reals) {
+                UniValue v;
+                v.setReal(d, format);
+                a.push_back(std::move(v));
+            }
+            json = UniValue::stringify(arr);
+            return json.size() > count;
+        });
+    }
+
+    // Amounts with 8 decimals, read as exact satoshis rather than as doubles
+    std::cout << "\n--- UniValue lib (amounts with 8 decimals, as read from JSON) ---\n";
+    std::vector<int64_t> sats(count);
+    std::string amountsJson = "[";
+    for (size_t i = 0; i < count; ++i) {
+        sats[i] = int64_t(uint64_t(ints[i]) % 2'100'000'000'000'000);
+        amountsJson += std::to_string(sats[i] / 100'000'000) + "." + std::to_string(100'000'000 + sats[i] % 100'000'000).substr(1) + ",";
+    }
+    amountsJson.back() = ']';
+    UniValue amounts;
+    ok = ok && amounts.read(amountsJson);
+    sum = 0;
+    ok = ok && runbench_number("get_real()", N, count, [&] {
+        for (const auto &v : amounts.get_array())
+            sum += v.get_real();
+        return true;
+    });
+    int64_t total = 0;
+    ok = ok && runbench_number("get_fixed(8)", N, count, [&] {
+        for (const auto &v : amounts.get_array())
+            total += v.get_fixed(8);
+        return true;
+    });
+    ok = ok && runbench_number("Assign and stringify, setFixed(8)", N, count, [&] {
+        auto &a = arr.setArray();
+        a.reserve(count);
+        for (const int64_t s : sats) {
+            UniValue v;
+            v.setFixed(s, 8);
+            a.push_back(std::move(v));
+        }
+        json = UniValue::stringify(arr);
+        return json == amountsJson;
+    });
+    return ok;
+}
+
 } // namespace
 
 int main(int argc, char *argv[])
@@ -435,6 +816,8 @@ int main(int argc, char *argv[])
         }
         std::cout << "\n";
     }
+    if (!runbench_numbers())
+        ++failct;
     return bool(failct);
 }
 
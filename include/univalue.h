@@ -8,13 +8,19 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstdint>
 #include <cstddef>
 #include <exception>
+#include <functional>
 #include <initializer_list>
+#include <iterator>
 #include <limits>
 #include <memory>
+#include <memory_resource>
+#include <new>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <tuple>
@@ -276,6 +282,51 @@ public:
 template<typename ...Ts> struct visitor : Ts... { using Ts::operator()...; };
 template<typename ...Ts> visitor(Ts...) -> visitor<Ts...>;
 
+/// Allocator used for the storage of UniValue::Object and UniValue::Array. It allocates from a std::pmr memory
+/// resource if one was given, or directly from the heap (via operator new) otherwise.
+///
+/// This is used rather than std::pmr::polymorphic_allocator so that the common case of no memory resource costs
+/// nothing over std::allocator: no virtual call per allocation, and no uses-allocator construction of elements.
+/// Like std::pmr::polymorphic_allocator, copies of containers use the heap, while moves keep the memory resource.
+template<typename T>
+class resource_allocator {
+    template<typename U> friend class resource_allocator;
+    std::pmr::memory_resource *mr = nullptr;
+
+public:
+    using value_type = T;
+
+    constexpr resource_allocator() noexcept = default;
+    constexpr resource_allocator(std::pmr::memory_resource *mr_) noexcept : mr(mr_) {}
+    template<typename U>
+    constexpr resource_allocator(const resource_allocator<U> &o) noexcept : mr(o.mr) {}
+
+    [[nodiscard]]
+    T *allocate(size_t n) {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T))
+            throw std::bad_array_new_length();
+        if (!mr)
+            return static_cast<T *>(::operator new(n * sizeof(T)));
+        return static_cast<T *>(mr->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T *p, size_t n) noexcept {
+        if (!mr)
+            ::operator delete(p);
+        else
+            mr->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    resource_allocator select_on_container_copy_construction() const noexcept { return {}; }
+
+    /// Returns the memory resource in use, or nullptr if this allocates from the heap.
+    constexpr std::pmr::memory_resource *resource() const noexcept { return mr; }
+
+    template<typename U>
+    constexpr bool operator==(const resource_allocator<U> &o) const noexcept { return mr == o.mr; }
+    template<typename U>
+    constexpr bool operator!=(const resource_allocator<U> &o) const noexcept { return mr != o.mr; }
+};
+
 } // namespace univalue_detail
 
 
@@ -309,11 +360,14 @@ public:
 
     public:
         using mapped_type = UniValue;
+        /// Keys are plain strings, each owning its characters. The short keys typical of JSON (up to 15 bytes with
+        /// the common standard libraries) are stored within the std::string itself, without a heap allocation, which
+        /// is why keys are not interned: sharing storage between identical keys would save no allocations for them.
         using key_type = std::string;
         using value_type = std::pair<key_type, mapped_type>;
 
     private:
-        using Vector = std::vector<value_type>;
+        using Vector = std::vector<value_type, univalue_detail::resource_allocator<value_type>>;
         Vector vector;
 
     public:
@@ -324,6 +378,12 @@ public:
         using const_reverse_iterator = Vector::const_reverse_iterator;
 
         Object() noexcept = default;
+        using allocator_type = Vector::allocator_type;
+
+        /// Constructs an empty object whose storage is allocated from `mr` (which must outlive it), or from the heap
+        /// if `mr` is nullptr. Values later inserted via push_back() or emplace_back() inherit `mr`, see resource().
+        /// Copies of the object use the heap, while moves keep using `mr`.
+        explicit Object(std::pmr::memory_resource *mr) noexcept : vector(mr) {}
         Object(std::initializer_list<value_type> il) : vector(il) {}
         explicit Object(const Object&) = default;
         Object(Object&&) noexcept = default;
@@ -508,8 +568,8 @@ public:
          *
          * Complexity: amortized constant (or constant if properly reserve()d).
          */
-        void push_back(const value_type& entry) { vector.push_back(entry); }
-        void push_back(value_type&& entry) { vector.push_back(std::move(entry)); }
+        void push_back(const value_type& entry) { vector.push_back(entry); adoptBack(); }
+        void push_back(value_type&& entry) { vector.push_back(std::move(entry)); adoptBack(); }
 
         /**
          * Constructs a key-value pair in-place at the end of the object.
@@ -521,7 +581,23 @@ public:
          * Complexity: amortized constant (or constant if properly reserve()d).
          */
         template<class... Args>
-        void emplace_back(Args&&... args) { vector.emplace_back(std::forward<Args>(args)...); }
+        void emplace_back(Args&&... args) { vector.emplace_back(std::forward<Args>(args)...); adoptBack(); }
+
+        /**
+         * Returns the memory resource the storage of this object is allocated from, or nullptr if it is allocated
+         * from the heap.
+         *
+         * If not nullptr, the resource propagates to the values inserted into this object with push_back() and
+         * emplace_back(): any objects and arrays within an inserted value are reallocated from this resource,
+         * recursively, unless they already use it.
+         *
+         * Complexity: constant.
+         */
+        [[nodiscard]]
+        std::pmr::memory_resource *resource() const noexcept { return vector.get_allocator().resource(); }
+
+        [[nodiscard]]
+        allocator_type get_allocator() const noexcept { return vector.get_allocator(); }
 
         /**
          * Removes the key-value pairs in the range [first, last).
@@ -548,6 +624,9 @@ public:
          */
         [[nodiscard]]
         bool operator!=(const Object& other) const noexcept { return !(*this == other); }
+
+    private:
+        inline void adoptBack();
     };
 
     class Array {
@@ -556,7 +635,7 @@ public:
         using value_type = UniValue;
 
     private:
-        using Vector = std::vector<value_type>;
+        using Vector = std::vector<value_type, univalue_detail::resource_allocator<value_type>>;
         Vector vector;
 
     public:
@@ -567,6 +646,12 @@ public:
         using const_reverse_iterator = Vector::const_reverse_iterator;
 
         Array() noexcept = default;
+        using allocator_type = Vector::allocator_type;
+
+        /// Constructs an empty array whose storage is allocated from `mr` (which must outlive it), or from the heap
+        /// if `mr` is nullptr. Values later inserted via push_back() or emplace_back() inherit `mr`, see resource().
+        /// Copies of the array use the heap, while moves keep using `mr`.
+        explicit Array(std::pmr::memory_resource *mr) noexcept : vector(mr) {}
         Array(std::initializer_list<value_type> il) : vector(il) {}
         explicit Array(const Array&) = default;
         Array(Array&&) noexcept = default;
@@ -700,13 +785,50 @@ public:
         [[nodiscard]]
         const UniValue& back() const noexcept;
 
+        /**
+         * Converts the first `count` values (or all of them, if there are fewer) to numbers, as get_int(),
+         * get_uint(), get_int64(), get_uint64() or get_real() would, and writes them to `out`.
+         *
+         * Returns the number of values converted. If that is less than std::min(count, size()), it is the index of
+         * the first value that is not a number or is out of range. The values before it have been written to `out`,
+         * and the rest of `out` is left as is. Nothing is thrown for such a value.
+         *
+         * Integers that are held as the text they were read from are parsed directly from it, 8 digits at a time,
+         * without the per-value checks of get_int() and friends. Doubles are converted one at a time, as get_real()
+         * would.
+         *
+         * Complexity: linear in the number of values converted.
+         */
+        size_type to_numbers(int *out, size_type count) const;
+        size_type to_numbers(unsigned *out, size_type count) const;
+        size_type to_numbers(int64_t *out, size_type count) const;
+        size_type to_numbers(uint64_t *out, size_type count) const;
+        size_type to_numbers(double *out, size_type count) const;
+
+        /**
+         * Returns all of the values converted to numbers of type T (int, unsigned, int64_t, uint64_t or double), as
+         * to_numbers() converts them.
+         *
+         * Throws std::runtime_error, naming its index, if a value is not a number or is out of range.
+         *
+         * Complexity: linear in number of elements.
+         */
+        template <typename T>
+        [[nodiscard]]
+        std::vector<T> to_vector() const {
+            std::vector<T> ret(vector.size());
+            if (const size_type converted = to_numbers(ret.data(), ret.size()); converted != ret.size())
+                throwNotNumber(converted);
+            return ret;
+        }
+
         /**
          * Pushes the value onto the end of the array.
          *
          * Complexity: amortized constant (or constant if properly reserve()d).
          */
-        void push_back(const value_type& entry) { vector.push_back(entry); }
-        void push_back(value_type&& entry) { vector.push_back(std::move(entry)); }
+        void push_back(const value_type& entry) { vector.push_back(entry); adoptBack(); }
+        void push_back(value_type&& entry) { vector.push_back(std::move(entry)); adoptBack(); }
 
         /**
          * Constructs a value in-place at the end of the array.
@@ -714,7 +836,23 @@ public:
          * Complexity: amortized constant (or constant if properly reserve()d).
          */
         template<class... Args>
-        void emplace_back(Args&&... args) { vector.emplace_back(std::forward<Args>(args)...); }
+        void emplace_back(Args&&... args) { vector.emplace_back(std::forward<Args>(args)...); adoptBack(); }
+
+        /**
+         * Returns the memory resource the storage of this array is allocated from, or nullptr if it is allocated
+         * from the heap.
+         *
+         * If not nullptr, the resource propagates to the values inserted into this array with push_back() and
+         * emplace_back(): any objects and arrays within an inserted value are reallocated from this resource,
+         * recursively, unless they already use it.
+         *
+         * Complexity: constant.
+         */
+        [[nodiscard]]
+        std::pmr::memory_resource *resource() const noexcept { return vector.get_allocator().resource(); }
+
+        [[nodiscard]]
+        allocator_type get_allocator() const noexcept { return vector.get_allocator(); }
 
         /**
          * Removes the values in the range [first, last).
@@ -739,6 +877,14 @@ public:
          */
         [[nodiscard]]
         bool operator!=(const Array& other) const noexcept { return !(*this == other); }
+
+    private:
+        inline void adoptBack();
+
+        // Used internally by to_numbers() and to_vector()
+        template <typename T>
+        size_type toNumbers(T *out, size_type count) const;
+        [[noreturn]] static void throwNotNumber(size_type index);
     };
 
     using size_type = Object::size_type;
@@ -807,6 +953,12 @@ public:
     UniValue& operator=(const UniValue &o) = default;
     UniValue& operator=(UniValue &&o) = default;
 
+    // Allocator-extended copy and move construction: all objects and arrays within the new value (recursively) are
+    // allocated from `mr`, or from the heap if `mr` is nullptr. The move constructor only reallocates those that do
+    // not already use `mr`. Note that strings are always allocated from the heap (if too long for SSO).
+    UniValue(const UniValue& o, std::pmr::memory_resource *mr);
+    UniValue(UniValue&& o, std::pmr::memory_resource *mr);
+
     // Misc. convenience constructors
     UniValue(bool val_) noexcept : var(val_) {}
     explicit UniValue(const Object& object) : var(object) {}
@@ -826,12 +978,24 @@ public:
     UniValue(std::string&& val_) noexcept : UniValue(VSTR, std::move(val_)) {}
     UniValue(const char* val_) : UniValue(VSTR, val_) {}
 
+    /// Selects how a double is written as JSON text. See setReal().
+    enum class RealFormat : uint8_t {
+        /// The fewest significant digits that read back as exactly the same double, e.g. "0.30000000000000004" for
+        /// 0.1 + 0.2, in the same notation as Legacy16 (so 100000.0 is still "100000", and 0.0001 is "0.0001").
+        Shortest,
+        /// 16 significant digits, as by printf("%.16g"), e.g. "0.3" for 0.1 + 0.2. This is how operator=(double) and
+        /// the double constructor write doubles. The text does not always read back as the same double.
+        Legacy16,
+    };
+
     void setNull() { var.reset(); }
     void operator=(bool val) { var = val; }
     Object& setObject() { return var.emplace<Object>(); }
+    Object& setObject(std::pmr::memory_resource *mr) { return var.emplace<Object>(mr); }
     Object& operator=(const Object& object) { return var.emplace<Object>(object); }
     Object& operator=(Object&& object) { return var.emplace<Object>(std::move(object)); }
     Array& setArray() { return var.emplace<Array>(); }
+    Array& setArray(std::pmr::memory_resource *mr) { return var.emplace<Array>(mr); }
     Array& operator=(const Array& array) { return var.emplace<Array>(array); }
     Array& operator=(Array&& array) { return var.emplace<Array>(std::move(array)); }
     void setNumStr(const char* val); // TODO: refactor to assign null on failure
@@ -843,7 +1007,14 @@ public:
     void operator=(unsigned val);
     void operator=(unsigned long val);
     void operator=(unsigned long long val);
-    void operator=(double val);
+    void operator=(double val); // same as setReal(val, RealFormat::Legacy16)
+    /// Assigns `val`, to be written as JSON text in `format`. NaN and infinity are not valid JSON, so for these, null
+    /// is assigned instead.
+    void setReal(double val, RealFormat format);
+    /// Assigns the number scaled / 10^decimals, written with exactly `decimals` decimal places, e.g. "32520.00000000"
+    /// for 3252000000000 with 8 decimals. No floating point is involved. Throws std::runtime_error if `decimals` is
+    /// more than 18.
+    void setFixed(int64_t scaled, unsigned decimals);
     std::string& operator=(std::string_view val) { return var.emplace<std::string>(val); }
     std::string& operator=(std::string&& val) { return var.emplace<std::string>(std::move(val)); }
     std::string& operator=(const char* val_) { return operator=(std::string_view(val_)); }
@@ -854,6 +1025,7 @@ public:
         var.visit(univalue_detail::visitor{
            [&](bool b) { ret = b ? VTRUE : VFALSE; },
            [&](const NumStr &) { ret = VNUM; },
+           [&](const NumBin &) { ret = VNUM; },
            [&](const std::string &) { ret = VSTR; },
            [&](const Object &) { ret = VOBJ; },
            [&](const Array &) { ret = VARR; },
@@ -865,7 +1037,7 @@ public:
     constexpr const std::string& getValStr() const noexcept {
         switch (type()) {
         case VSTR: return var.get<std::string>();
-        case VNUM: return var.get<NumStr>();
+        case VNUM: return var.holds_alternative<NumStr>() ? var.get<NumStr>() : var.get<NumBin>().str();
         default: return emptyVal;
         }
     }
@@ -904,6 +1076,22 @@ public:
         }
     }
 
+    /**
+     * VOBJ/VARR: Returns the memory resource the storage of the object/array is allocated from, or nullptr if it is
+     *            allocated from the heap. See Object::resource() and Array::resource().
+     * Other types: Returns nullptr.
+     *
+     * Complexity: constant.
+     */
+    [[nodiscard]]
+    std::pmr::memory_resource *resource() const noexcept {
+        switch (type()) {
+        case VOBJ: return var.get<Object>().resource();
+        case VARR: return var.get<Array>().resource();
+        default: return nullptr;
+        }
+    }
+
     [[nodiscard]]
     constexpr bool getBool() const noexcept { return isTrue(); }
 
@@ -950,7 +1138,14 @@ public:
      * Complexity: linear in the amount of data to compare.
      */
     [[nodiscard]]
-    bool operator==(const UniValue& other) const noexcept { return var == other.var; }
+    bool operator==(const UniValue& other) const noexcept {
+        if (var.index() != other.var.index() && isNum() && other.isNum()) {
+            // a number held as text and one held in binary are equal if their JSON text is
+            char buf[NumBin::maxTextLen], otherBuf[NumBin::maxTextLen];
+            return numText(buf) == other.numText(otherBuf);
+        }
+        return var == other.var;
+    }
 
     /**
      * Returns whether the UniValues are not of the same type or contain unequal data.
@@ -1086,6 +1281,21 @@ public:
         return s;
     }
 
+    /**
+     * Selects the engine used by read(). All engines accept exactly the same inputs and produce identical results,
+     * including the error position on failure.
+     */
+    enum class ReadEngine : uint8_t {
+        /// The library default: Tokenizer, unless the library was built with READ_ENGINE_STRUCTURAL_INDEX=ON.
+        Default,
+        /// Tokenizes and builds the tree in a single pass over the input. This is the reference implementation.
+        Tokenizer,
+        /// First builds an index of the structural characters of the entire input using SIMD (stage 1), then builds
+        /// the tree by walking this index (stage 2). Tends to be faster on large inputs. On invalid input, this falls
+        /// back to the Tokenizer engine in order to determine the error position.
+        StructuralIndex,
+    };
+
     /**
      * Parses a NUL-terminated JSON string.
      *
@@ -1098,9 +1308,53 @@ public:
      *
      * Optional arg errpos: If specified, the pointer will be set to point to where parsing failed in the input string.
      * The pointer is only set to a valid value on failure, otherwise it is set to nullptr.
+     *
+     * Optional arg engine: The parsing engine to use, see ReadEngine.
+     *
+     * Optional arg mr: The memory resource to allocate all objects and arrays of the read value from (nullptr: the
+     * heap). It must outlive the value. See also UniValue::Document.
+     */
+    [[nodiscard]]
+    const char* read(const char* raw, const char **errpos = nullptr, ReadEngine engine = ReadEngine::Default,
+                     std::pmr::memory_resource *mr = nullptr);
+
+    /**
+     * Parses a JSON buffer of `len` bytes starting at `raw`. The buffer need not be NUL-terminated, and is never read
+     * beyond its end in any way that matters (so it may e.g. point directly into a network receive buffer).
+     * An embedded NUL is rejected as invalid JSON.
+     *
+     * If valid JSON, `raw + len` is returned, and the object state represents the read value.
+     * If invalid JSON, nullptr is returned, and the object is in a valid but unspecified state.
+     *
+     * Optional arg errpos: If specified, the pointer will be set to point to where parsing failed in the input buffer.
+     * The pointer is only set to a valid value on failure, otherwise it is set to nullptr.
+     *
+     * Optional arg engine: The parsing engine to use, see ReadEngine.
+     *
+     * Optional arg mr: The memory resource to allocate all objects and arrays of the read value from (nullptr: the
+     * heap). It must outlive the value. See also UniValue::Document.
      */
     [[nodiscard]]
-    const char* read(const char* raw, const char **errpos = nullptr);
+    const char* read(const char* raw, size_t len, const char **errpos = nullptr, ReadEngine engine = ReadEngine::Default,
+                     std::pmr::memory_resource *mr = nullptr);
+
+    /**
+     * Parses a JSON std::string_view. The view need not be NUL-terminated. An embedded NUL is rejected as invalid JSON.
+     *
+     * If valid JSON, true is returned, and the object state represents the read value.
+     * If invalid JSON, false is returned, and the object is in a valid but unspecified state.
+     *
+     * Optional arg errpos: If specified, it will be set to the position where parsing failed in the input.
+     * It is only set to the position on failure, otherwise it is set to std::string_view::npos.
+     *
+     * Optional arg engine: The parsing engine to use, see ReadEngine.
+     *
+     * Optional arg mr: The memory resource to allocate all objects and arrays of the read value from (nullptr: the
+     * heap). It must outlive the value. See also UniValue::Document.
+     */
+    [[nodiscard]]
+    bool read(std::string_view raw, std::string_view::size_type *errpos = nullptr,
+              ReadEngine engine = ReadEngine::Default, std::pmr::memory_resource *mr = nullptr);
 
     /**
      * Parses a JSON std::string.
@@ -1112,9 +1366,183 @@ public:
      *
      * Optional arg errpos: If specified, the pointer will be set to the position where parsing failed in the input string.
      * The pointer is only set to the position on failure, otherwise it is set to std::string::npos.
+     *
+     * Optional arg engine: The parsing engine to use, see ReadEngine.
+     *
+     * Optional arg mr: The memory resource to allocate all objects and arrays of the read value from (nullptr: the
+     * heap). It must outlive the value. See also UniValue::Document.
+     */
+    [[nodiscard]]
+    bool read(const std::string& raw, std::string::size_type *errpos = nullptr, ReadEngine engine = ReadEngine::Default,
+              std::pmr::memory_resource *mr = nullptr);
+
+    /**
+     * Same as read(), but instead of discarding the current value first, the new value is read over it, recycling
+     * the storage of the old tree: object members and array elements are overwritten in order (keys and strings are
+     * assigned to, keeping their capacity), and only the elements left over at the end of each object or array are
+     * destroyed. Storage is only lost where the type of a value differs from that of the old value in its place.
+     *
+     * Thus, repeatedly reading documents of a similar shape into the same UniValue does close to no allocations once
+     * it has "warmed up". New objects and arrays are allocated from resource(), i.e. from the same memory resource as
+     * the current value if it is an object or array.
+     *
+     * On failure, the value is in a valid but unspecified state (parts of it may have been overwritten).
+     */
+    [[nodiscard]]
+    const char* readInPlace(const char* raw, size_t len, const char **errpos = nullptr,
+                            ReadEngine engine = ReadEngine::Default);
+
+    /// Same as read(std::string_view), but recycles the storage of the current value. See the overload above.
+    [[nodiscard]]
+    bool readInPlace(std::string_view raw, std::string_view::size_type *errpos = nullptr,
+                     ReadEngine engine = ReadEngine::Default);
+
+    /**
+     * Same as read(), but if the JSON is an object or array, its top-level members or elements are read by up to
+     * `threads` threads in parallel, directly into their place in the result. The default of 0 uses as many threads
+     * as there are CPU cores, but no more than one per 16 KiB of input.
+     * The result, including the error position on failure, is the same as that of read().
+     *
+     * The input is first indexed (see ReadEngine::StructuralIndex) in order to find the boundaries of the top-level
+     * members or elements, which are then divided among the threads in runs of about equal size (one of which is read
+     * by the calling thread). On invalid input, the input is read again by read() in order to determine the
+     * error position.
+     */
+    [[nodiscard]]
+    const char* readParallel(const char* raw, size_t len, const char **errpos = nullptr, unsigned threads = 0);
+
+    /// Same as read(std::string_view), but parallelized as described above.
+    [[nodiscard]]
+    bool readParallel(std::string_view raw, std::string_view::size_type *errpos = nullptr, unsigned threads = 0);
+
+    /// A read-only view of the contents of a file, which is memory-mapped where possible. See the definition below.
+    class MappedFile;
+
+    /**
+     * Reads the JSON file at `path`. The file is memory-mapped (see MappedFile) and parsed directly from the mapping,
+     * so that even a very large file is never copied to memory as a whole. Otherwise the same as
+     * read(std::string_view), with `errpos` being the offset in the file. Throws std::runtime_error if the file cannot
+     * be read.
+     */
+    [[nodiscard]]
+    bool readFile(const std::string &path, std::string_view::size_type *errpos = nullptr,
+                  ReadEngine engine = ReadEngine::Default);
+
+    /// A set of paths that selects values of a JSON document, for readFiltered(). See the definition below.
+    class PathFilter;
+
+    /// Parses a JSON buffer of `len` bytes starting at `raw`, but only builds the values selected by `filter`, along
+    /// with the objects and arrays on the way to them. Everything else is skipped as it is parsed: it is validated
+    /// exactly as read() validates it, but never stored, and skipping allocates no memory.
+    ///
+    /// Objects and arrays keep only those of their members or elements that are, or that lead to, a selected value, in
+    /// document order. So, for instance, with the paths "/tx/*/txid" and "/height", a block becomes
+    /// {"height": ..., "tx": [{"txid": ...}, {"txid": ...}, ...]}. An object or array that ends up with nothing in it
+    /// is dropped as well (and if that is the root, the result is null).
+    ///
+    /// Returns and sets `errpos` just like read(). This UniValue is cleared first.
+    [[nodiscard]]
+    const char* readFiltered(const char* raw, size_t len, const PathFilter &filter, const char **errpos = nullptr);
+
+    /// Same as above, for a std::string_view. If specified, `errpos` is set to std::string_view::npos on success.
+    [[nodiscard]]
+    bool readFiltered(std::string_view raw, const PathFilter &filter, std::string_view::size_type *errpos = nullptr);
+
+    /// The key sequence of an object, with an index from key to position, for locating the values of many objects
+    /// that share the same keys (such as the elements of an array of records) quickly. See the definition below.
+    class Shape;
+
+    /// A parsed JSON document that owns an arena from which the storage of all of its objects and arrays is
+    /// allocated. See the definition below.
+    class Document;
+
+    /// An incremental ("push") parser, which reads a JSON document that arrives in chunks. See the definition below.
+    class StreamReader;
+
+    /// Receives the events of readSax(). See the definition below.
+    class SaxHandler;
+
+    /// A parsed JSON document whose values are only materialized as UniValues on demand, and a handle to one of its
+    /// values. See the definitions below.
+    class LazyDocument;
+    class LazyValue;
+
+    /**
+     * Parses a JSON buffer of `len` bytes starting at `raw` without building a tree: instead, `handler` receives an
+     * event for each value, key and object or array boundary, in document order. The input is validated exactly as
+     * read() validates it, however events are emitted as the input is parsed, so on invalid input the handler will have
+     * received the events of whatever preceded the error.
+     *
+     * Returns true if the input is valid JSON and no event handler returned false. Otherwise, false is returned, and if
+     * `errpos` is specified, it is set to the position at which parsing stopped (the same position that read() reports
+     * for invalid input).
+     */
+    [[nodiscard]]
+    static bool readSax(const char* raw, size_t len, SaxHandler &handler, const char **errpos = nullptr);
+
+    /// Same as above, for a std::string_view. If specified, `errpos` is set to std::string_view::npos on success.
+    [[nodiscard]]
+    static bool readSax(std::string_view raw, SaxHandler &handler, std::string_view::size_type *errpos = nullptr);
+
+    /// Receives the values of readLines(): the (0-based) line number of each, and the value itself. Returning false
+    /// stops the reading.
+    using LineHandler = std::function<bool(size_t line, UniValue &&value)>;
+
+    /**
+     * Parses newline-delimited JSON (NDJSON, a.k.a. JSON Lines): one JSON value per line of `text`. Lines that are
+     * empty or contain only whitespace (such as the '\r' of a "\r\n" line ending) are skipped.
+     *
+     * The input is divided into batches of whole lines, which are parsed on up to `threads` worker threads (0: as many
+     * as there are CPU cores; 1: on the calling thread only). Only a few batches are ever in flight at a time, so
+     * memory use is bounded whatever the size of the input. `handler` is always called on the calling thread: if
+     * `ordered`, with the values in input order, otherwise batch by batch, in whatever order the batches are done.
+     *
+     * Returns true if every line was valid and `handler` never returned false. Otherwise, false is returned, and if
+     * specified, `errpos` is set to the position in `text` at which reading stopped: that of the error, as read() would
+     * report it, or the end of the line whose value `handler` rejected. The values of the lines preceding the error
+     * have been delivered if `ordered` (otherwise, which of the other batches were delivered is unspecified). On
+     * success, `errpos` is set to std::string_view::npos.
+     */
+    [[nodiscard]]
+    static bool readLines(std::string_view text, const LineHandler &handler,
+                          std::string_view::size_type *errpos = nullptr, bool ordered = true, unsigned threads = 0);
+
+    /// Same as readLines(), for the contents of the file at `path`, which is memory-mapped (see MappedFile). Throws
+    /// std::runtime_error if the file cannot be read.
+    [[nodiscard]]
+    static bool readLinesFile(const std::string &path, const LineHandler &handler,
+                              std::string_view::size_type *errpos = nullptr, bool ordered = true, unsigned threads = 0);
+
+    /**
+     * The inverse of readLines(): returns the compact JSON of each of the `count` values at `values`, each followed by
+     * a newline. Runs of values are stringified on up to `threads` threads in parallel (0: as many as there are CPU
+     * cores, but no more than one per 64 values), and then concatenated in order.
+     */
+    static std::string writeLines(const UniValue *values, size_t count, unsigned threads = 0);
+
+    /// Same as above, for the elements of `values`.
+    static std::string writeLines(const Array &values, unsigned threads = 0) {
+        return writeLines(values.empty() ? nullptr : &*values.begin(), values.size(), threads);
+    }
+
+    /**
+     * Checks whether the `len` bytes starting at `raw` are valid JSON, without building anything: the input is
+     * validated exactly as read() validates it (the same grammar, UTF-8 and escape rules, and nesting depth limit), but
+     * no values are stored, and no memory is allocated.
+     *
+     * Returns true if the input is valid JSON. Otherwise, false is returned, and if `errpos` is specified, it is set to
+     * the position that read() would report for the input.
      */
     [[nodiscard]]
-    bool read(const std::string& raw, std::string::size_type *errpos = nullptr);
+    static bool validate(const char* raw, size_t len, const char **errpos = nullptr);
+
+    /// Same as above, for a std::string_view. If specified, `errpos` is set to std::string_view::npos on success.
+    [[nodiscard]]
+    static bool validate(std::string_view raw, std::string_view::size_type *errpos = nullptr);
+
+    /// Implementation detail: used by the read engines to construct parsed values directly in their final place.
+    /// Defined in univalue_read.cpp.
+    struct Parser;
 
 private:
     // "type tag" to differentiate a string containing a JSON numeric from a JSON string
@@ -1131,10 +1559,71 @@ private:
             return *this;
         }
     };
-    univalue_detail::variant<bool, NumStr, std::string, Object, Array> var;
+    /**
+     * "type tag" for a number held in binary, as assigned from a C++ integer or double. Its JSON text is only made
+     * when needed: stringify() formats it straight into the output, and getValStr() formats it once, on first use,
+     * into a string that is kept from then on (and is safely shared by threads reading the same value).
+     */
+    struct NumBin {
+        // (Real is written as RealFormat::Shortest, Real16 as Legacy16, and Fixed is i / 10^decimals, see setFixed())
+        enum Kind : uint8_t { Int, UInt, Real, Real16, Fixed };
+        static constexpr size_t maxTextLen = 32; ///< enough for any int64_t, uint64_t or double, see format()
+        static constexpr unsigned maxFixedDecimals = 18; ///< see setFixed() (10^18 is the largest power of 10 in an int64_t)
+
+        union Value { int64_t i; uint64_t u; double d; } val;
+        Kind kind;
+        uint8_t decimals = 0; ///< Fixed only
+
+        explicit NumBin(int64_t i) noexcept : kind(Int) { val.i = i; }
+        explicit NumBin(uint64_t u) noexcept : kind(UInt) { val.u = u; }
+        NumBin(double d, RealFormat format) noexcept : kind(format == RealFormat::Shortest ? Real : Real16) { val.d = d; }
+        NumBin(int64_t scaled, uint8_t decimals_) noexcept : kind(Fixed), decimals(decimals_) { val.i = scaled; }
+        NumBin(const NumBin &o) noexcept : val(o.val), kind(o.kind), decimals(o.decimals) {}
+        NumBin(NumBin &&o) noexcept : val(o.val), kind(o.kind), decimals(o.decimals), text(o.text.exchange(nullptr)) {}
+        NumBin &operator=(const NumBin &o) noexcept {
+            val = o.val;
+            kind = o.kind;
+            decimals = o.decimals;
+            delete text.exchange(nullptr);
+            return *this;
+        }
+        NumBin &operator=(NumBin &&o) noexcept {
+            val = o.val;
+            kind = o.kind;
+            decimals = o.decimals;
+            delete text.exchange(o.text.exchange(nullptr));
+            return *this;
+        }
+        ~NumBin() { delete text.load(std::memory_order_relaxed); }
+
+        /// Returns the JSON text of this number, written to `buf` (or the string made by str(), if there is one).
+        std::string_view format(char (&buf)[maxTextLen]) const;
+        /// Returns the JSON text of this number, as a string that lives as long as this NumBin.
+        const std::string &str() const;
+        /// Numbers are equal if their JSON text is.
+        bool operator==(const NumBin &o) const;
+
+    private:
+        mutable std::atomic<const std::string *> text{nullptr};
+    };
+    univalue_detail::variant<bool, NumStr, std::string, Object, Array, NumBin> var;
+
+    /// VNUM: Returns the JSON text of this number, written to `buf` if it is held in binary. Otherwise: undefined.
+    std::string_view numText(char (&buf)[NumBin::maxTextLen]) const {
+        return var.holds_alternative<NumStr>() ? std::string_view(var.get<NumStr>()) : var.get<NumBin>().format(buf);
+    }
 
     static const std::string emptyVal; ///< returned by getValStr() if this is not a VNUM or VSTR
 
+    /// Used by Object and Array to propagate their memory resource to inserted values: reallocates the objects and
+    /// arrays within `uv` from `mr`, unless `uv` is already allocated from it (or is not an object or array).
+    static void adoptResource(UniValue &uv, std::pmr::memory_resource *mr) {
+        if ((uv.var.holds_alternative<Object>() || uv.var.holds_alternative<Array>()) && uv.resource() != mr)
+            uv.reallocate(mr);
+    }
+    void reallocate(std::pmr::memory_resource *mr);
+    void reallocateChildren(std::pmr::memory_resource *mr);
+
     // Opaque type used for writing. This can be further optimized later.
     struct Stream {
         std::string & str; // this is a reference for RVO to always work in UniValue::stringify()
@@ -1154,6 +1643,15 @@ private:
     template<typename Int64>
     void setInt64(Int64 val);
 
+    // Used internally by get_int(), get_int64(), get_uint() and get_uint64()
+    template<typename Integer>
+    Integer getInt(const char *rangeError) const;
+
+    // Used internally by the getters above and Array::to_numbers(): converts this number to T, as get_int(),
+    // get_uint(), get_int64(), get_uint64() or get_real() would, but returns false instead of throwing.
+    template<typename T>
+    bool toNumber(T *out) const;
+
 public:
     // Strict type-specific getters, these throw std::runtime_error if the
     // value is of unexpected type
@@ -1167,6 +1665,16 @@ public:
 
     double get_real() const;
 
+    /**
+     * VNUM: Returns the number multiplied by 10^decimals, exactly, e.g. 3252000000000 for 32520.00000000 with 8
+     * decimals (an amount in satoshis). No floating point is involved, so there is no rounding.
+     * Other types: Throws std::runtime_error.
+     *
+     * Also throws std::runtime_error if the number has non-zero digits beyond `decimals` decimal places, if the result
+     * does not fit an int64_t, or if `decimals` is more than 18.
+     */
+    int64_t get_fixed(unsigned decimals) const;
+
     /**
      * VSTR: Returns a std::string reference to this value.
      * Other types: Throws std::runtime_error.
@@ -1237,7 +1745,501 @@ public:
     [[nodiscard]]
     static std::tuple<int, int, int> version();
 
+    /**
+     * @brief simdImplementation - query the set of kernels used by the parser and the serializer
+     * @return The name of the kernel implementation in use, e.g. "avx2", "sse2", "neon" or "scalar". By default this
+     *         is the best implementation supported by the CPU, as detected at runtime.
+     */
+    [[nodiscard]]
+    static const char *simdImplementation() noexcept;
+
+    /**
+     * @brief simdImplementations - query the kernel implementations supported by this build on this CPU
+     * @return The names of the supported implementations, best first. "scalar" is always last.
+     */
+    [[nodiscard]]
+    static std::vector<std::string> simdImplementations();
+
+    /**
+     * @brief setSimdImplementation - force the use of a particular kernel implementation (for testing/benchmarking)
+     * @param name One of the names returned by simdImplementations().
+     * @return true on success, false if `name` is not supported on this CPU (in which case nothing changes).
+     *
+     * Note: This is a process-wide setting. All implementations produce identical results.
+     */
+    static bool setSimdImplementation(std::string_view name);
+
     /// Rerpresents the "null" UniValue. A reference to this singleton is returned from some methods to indicate
     /// not found, etc. Its state is identical to a default-constructed UniValue instance.
     static const UniValue Null;
 };
+
+/**
+ * A parsed JSON document whose Object and Array storage is allocated from an arena (a monotonic buffer) owned by
+ * the document, rather than from the heap. Allocation is then a pointer bump, and freeing the tree is a single bulk
+ * release of the arena. Use this to parse many short-lived documents, e.g. in an RPC server.
+ *
+ * String values and keys are still std::strings, and are thus still allocated from the heap unless short enough to
+ * fit in the small string buffer.
+ *
+ * The root value may be inspected and modified in any way. However, note that objects and arrays that are *moved*
+ * out of the document keep using its arena, and thus must not outlive the document or its next read() or clear().
+ * Copies are always safe, as is an allocator-extended move to the heap: `UniValue(std::move(doc->at(i)), nullptr)`.
+ */
+class UniValue::Document {
+    std::pmr::monotonic_buffer_resource arena; // declared before `value` so that it is destroyed after it
+    UniValue value;
+
+public:
+    /// `initialArenaSize` is the size of the first buffer the arena allocates, and may be 0 to use a default size.
+    explicit Document(size_t initialArenaSize = 0);
+    Document(const Document &) = delete;
+    Document &operator=(const Document &) = delete;
+
+    /// Same as UniValue::read(), but the previous value is discarded by releasing the arena in bulk, and the new value
+    /// is allocated from it.
+    [[nodiscard]]
+    const char* read(const char* raw, size_t len, const char **errpos = nullptr,
+                     ReadEngine engine = ReadEngine::Default);
+    [[nodiscard]]
+    bool read(std::string_view raw, std::string_view::size_type *errpos = nullptr,
+              ReadEngine engine = ReadEngine::Default);
+
+    /// Sets the document to null, and releases all of the memory held by the arena.
+    void clear();
+
+    /// The root value of the document.
+    [[nodiscard]]
+    UniValue &root() noexcept { return value; }
+    [[nodiscard]]
+    const UniValue &root() const noexcept { return value; }
+    UniValue &operator*() noexcept { return value; }
+    const UniValue &operator*() const noexcept { return value; }
+    UniValue *operator->() noexcept { return &value; }
+    const UniValue *operator->() const noexcept { return &value; }
+};
+
+/**
+ * An incremental ("push") JSON parser, for input that arrives in chunks of arbitrary size, e.g. from a socket.
+ *
+ * Each chunk is parsed as soon as it is fed, so parsing overlaps with receiving the rest of the input, and the input
+ * need never be buffered in its entirety. Chunks may be split at any byte, including within strings, escapes and
+ * numbers: only the incomplete token at the end of a chunk (if any) is carried over to the next one.
+ *
+ * Accepts exactly the same documents as UniValue::read(), with the same results, and reports the same error position
+ * (as an offset into all of the input fed since construction or the last reset()).
+ */
+class UniValue::StreamReader {
+public:
+    /// Objects and arrays are allocated from `mr`, or from the heap if it is nullptr (see UniValue::read()).
+    explicit StreamReader(std::pmr::memory_resource *mr = nullptr);
+    StreamReader(const StreamReader &) = delete;
+    StreamReader &operator=(const StreamReader &) = delete;
+
+    /**
+     * Parses the next `len` bytes of input.
+     *
+     * Returns false if the input is already known to be invalid JSON, in which case errorPos() is set, and any further
+     * input is ignored.
+     */
+    [[nodiscard]]
+    bool feed(const char *data, size_t len);
+    [[nodiscard]]
+    bool feed(std::string_view data) { return feed(data.data(), data.size()); }
+
+    /**
+     * Signals the end of the input.
+     *
+     * If all of the input fed was valid JSON, true is returned, and root() holds the read value.
+     * If invalid JSON, false is returned, errorPos() is set, and root() is in a valid but unspecified state.
+     */
+    [[nodiscard]]
+    bool finish();
+
+    /// Sets root() to null and forgets all input fed so far, so that a new document may be read.
+    void reset();
+
+    /// The position in the input at which parsing failed, or std::string_view::npos if it has not failed (so far).
+    [[nodiscard]]
+    std::string_view::size_type errorPos() const noexcept { return errPos; }
+
+    /// The value read. It is only complete once finish() has returned true.
+    [[nodiscard]]
+    UniValue &root() noexcept { return value; }
+    [[nodiscard]]
+    const UniValue &root() const noexcept { return value; }
+    UniValue &operator*() noexcept { return value; }
+    const UniValue &operator*() const noexcept { return value; }
+    UniValue *operator->() noexcept { return &value; }
+    const UniValue *operator->() const noexcept { return &value; }
+
+private:
+    /// What the grammar allows next.
+    enum class State : uint8_t {
+        Value,       ///< a value, to be read into `*slot`
+        ArrayFirst,  ///< the first value of an array, or `]`
+        ObjectFirst, ///< the first key of an object, or `}`
+        Key,         ///< the key of the next object member
+        Colon,       ///< the `:` after a key
+        Next,        ///< `,` or the end of the innermost object or array
+        Done,        ///< nothing: the document is complete
+    };
+
+    UniValue value;
+    std::pmr::memory_resource *mr;
+    std::vector<UniValue *> stack; ///< the objects and arrays being read, innermost last
+    UniValue *slot;                ///< where the next value is read into
+    State state;
+    std::string pending; ///< the incomplete token at the end of the input fed so far
+    std::string scratch; ///< work area for unescaping strings
+    size_t offset;       ///< position in the input of `pending`, or else of the next byte to be fed
+    size_t errPos;
+
+    size_t pendingTokenEnd(const char *data, size_t len) const;
+    const char *parse(const char *begin, const char *end, bool final);
+};
+
+/**
+ * The event handler interface of UniValue::readSax(). Override the events of interest; the default implementations
+ * ignore the event. Each event returns true to continue parsing, or false to stop it (in which case readSax() returns
+ * false).
+ *
+ * The std::string_view arguments are only valid for the duration of the call. Numbers are passed as their JSON text,
+ * as getValStr() would return it. Strings and keys are passed unescaped.
+ */
+class UniValue::SaxHandler {
+public:
+    virtual ~SaxHandler() = default;
+
+    virtual bool onNull() { return true; }
+    virtual bool onBool(bool) { return true; }
+    virtual bool onNumber(std::string_view) { return true; }
+    virtual bool onString(std::string_view) { return true; }
+
+    virtual bool onStartObject() { return true; }
+    /// The key of the next member of the innermost object. The event for its value follows.
+    virtual bool onKey(std::string_view) { return true; }
+    virtual bool onEndObject(size_t /* memberCount */) { return true; }
+
+    virtual bool onStartArray() { return true; }
+    virtual bool onEndArray(size_t /* elementCount */) { return true; }
+};
+
+/**
+ * A value of a UniValue::LazyDocument. This is a lightweight handle that may be copied freely, but which must not
+ * outlive its document (nor the document's next read() or clear()).
+ *
+ * The accessors mirror those of UniValue, except that they return the member or element looked up as another
+ * LazyValue, and that values other than objects and arrays must be materialized to get at their contents (or by using
+ * the get_*() shorthands). Looking up a member or element skips over all of the values that precede it, at a cost of
+ * a jump for each object or array and of a scan for any other value.
+ *
+ * A default-constructed LazyValue is null, as is the result of looking up a missing key or index with the [] operator.
+ */
+class UniValue::LazyValue {
+public:
+    class iterator;
+
+    LazyValue() noexcept = default;
+
+    [[nodiscard]]
+    VType type() const noexcept;
+    [[nodiscard]]
+    bool is(int types) const noexcept { return type() & types; }
+    [[nodiscard]]
+    bool isNull() const noexcept { return is(VNULL); }
+    [[nodiscard]]
+    bool isTrue() const noexcept { return is(VTRUE); }
+    [[nodiscard]]
+    bool isFalse() const noexcept { return is(VFALSE); }
+    [[nodiscard]]
+    bool isBool() const noexcept { return is(MBOOL); }
+    [[nodiscard]]
+    bool isStr() const noexcept { return is(VSTR); }
+    [[nodiscard]]
+    bool isNum() const noexcept { return is(VNUM); }
+    [[nodiscard]]
+    bool isArray() const noexcept { return is(VARR); }
+    [[nodiscard]]
+    bool isObject() const noexcept { return is(VOBJ); }
+
+    /// VOBJ/VARR: Returns the number of members or elements. Other types: Returns 0. Complexity: constant.
+    [[nodiscard]]
+    size_type size() const noexcept;
+    [[nodiscard]]
+    bool empty() const noexcept { return size() == 0; }
+
+    /// Same as UniValue::operator[](std::string_view), i.e. a missing key (or a non-object) yields null.
+    /// Complexity: linear in the number of members preceding the key.
+    [[nodiscard]]
+    LazyValue operator[](std::string_view key) const;
+
+    /// Same as UniValue::operator[](size_type). Complexity: linear in the index.
+    [[nodiscard]]
+    LazyValue operator[](size_type index) const;
+
+    /// Same as UniValue::locate(), but returns the value by value (or std::nullopt if the key does not exist).
+    [[nodiscard]]
+    std::optional<LazyValue> locate(std::string_view key) const;
+
+    /// Same as UniValue::at(std::string_view): throws std::out_of_range for a missing key, or std::domain_error if
+    /// this is not an object.
+    LazyValue at(std::string_view key) const;
+
+    /// Same as UniValue::at(size_type): throws std::out_of_range for a missing index, or std::domain_error if this is
+    /// not an object or array.
+    LazyValue at(size_type index) const;
+
+    /// VOBJ/VARR: Iterates over the members or elements, see LazyValue::iterator. Other types: An empty range.
+    [[nodiscard]]
+    iterator begin() const;
+    [[nodiscard]]
+    iterator end() const noexcept;
+
+    /// Returns this value, including everything it contains, as a UniValue.
+    [[nodiscard]]
+    UniValue materialize() const;
+
+    // Shorthands for materialize().get_*(), which throw in the same way as those if the type does not match
+    bool get_bool() const;
+    int get_int() const;
+    int64_t get_int64() const;
+    unsigned get_uint() const;
+    uint64_t get_uint64() const;
+    double get_real() const;
+    int64_t get_fixed(unsigned decimals) const;
+    std::string get_str() const;
+    std::string getValStr() const;
+
+private:
+    friend class LazyDocument;
+    friend class iterator;
+
+    const LazyDocument *doc = nullptr; ///< nullptr for null values that are not in the document
+    size_t pos = 0;                    ///< the offset in the input of the first character of the value
+    size_t ordinal = 0;                ///< for objects and arrays, their index in LazyDocument::containers
+
+    LazyValue(const LazyDocument *doc_, size_t pos_, size_t ordinal_) noexcept
+        : doc(doc_), pos(pos_), ordinal(ordinal_) {}
+};
+
+/**
+ * Iterates over the members of an object, or the elements of an array, of a UniValue::LazyDocument. Dereferencing
+ * yields the member or element, and for object members, key() returns its key.
+ */
+class UniValue::LazyValue::iterator {
+public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = LazyValue;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const LazyValue *;
+    using reference = const LazyValue &;
+
+    iterator() noexcept = default;
+
+    reference operator*() const noexcept { return value; }
+    pointer operator->() const noexcept { return &value; }
+
+    /// The key of the current object member, unescaped. The view is valid until the iterator is next modified (and
+    /// for as long as the document, if the key contains no escapes).
+    [[nodiscard]]
+    std::string_view key() const;
+
+    iterator &operator++() { advance(); return *this; }
+
+    bool operator==(const iterator &o) const noexcept { return value.doc == o.value.doc && value.pos == o.value.pos; }
+    bool operator!=(const iterator &o) const noexcept { return !(*this == o); }
+
+private:
+    friend class LazyValue;
+
+    LazyValue value;         ///< the current member or element, or null at the end
+    size_t next = 0;         ///< the offset in the input just past the current value
+    size_t nextOrdinal = 0;  ///< the ordinal of the next object or array
+    size_t keyPos = 0;       ///< the offset in the input of the key of the current member
+    bool object = false;
+    mutable std::string scratch; ///< the key, if it needed unescaping
+
+    void advance();
+};
+
+/**
+ * A parsed JSON document whose values are only materialized on demand ("lazily"), for read-mostly access to a few of
+ * the values of a large document.
+ *
+ * read() validates the input exactly as UniValue::read() does, and indexes the extent of each of its objects and
+ * arrays, but builds no tree: the document is then navigated through LazyValue handles, and only the values actually
+ * needed are materialized as UniValues. Values that are never looked at cost nothing beyond this first pass.
+ *
+ * The document refers to the input rather than copying it, so the input must remain valid and unmodified for as long as
+ * the document is in use.
+ */
+class UniValue::LazyDocument {
+public:
+    LazyDocument() = default;
+    LazyDocument(const LazyDocument &) = delete;
+    LazyDocument &operator=(const LazyDocument &) = delete;
+
+    /// Same as UniValue::read(std::string_view), except that only the index is built. On failure, the document is
+    /// empty, i.e. its root() is null.
+    [[nodiscard]]
+    bool read(std::string_view raw, std::string_view::size_type *errpos = nullptr);
+
+    /// Empties the document, releasing its index.
+    void clear() noexcept;
+
+    [[nodiscard]]
+    LazyValue root() const noexcept { return json.empty() ? LazyValue{} : LazyValue{this, rootPos, 0}; }
+
+private:
+    friend class LazyValue;
+    friend class LazyValue::iterator;
+
+    struct Container {
+        size_t end;  ///< the offset in the input just past the closing bracket
+        size_t size; ///< the number of members or elements
+        size_t next; ///< the ordinal of the next object or array after this one and everything within it
+    };
+    struct IndexSink;
+
+    std::string_view json;
+    size_t rootPos = 0;
+    std::vector<Container> containers; ///< all objects and arrays, in document order (by ordinal)
+};
+
+/**
+ * A read-only view of the contents of a file, for parsing large files without first copying them to memory.
+ *
+ * On POSIX systems, a regular file is memory-mapped, with hints that it is about to be read once, sequentially (the
+ * pages are pre-faulted with MAP_POPULATE where available, and read ahead aggressively). Anything else (such as a pipe,
+ * or any file on other systems) is read into a buffer instead. Either way, the contents are not NUL-terminated: they
+ * are meant for the length-bounded read functions, such as UniValue::read(const char*, size_t).
+ */
+class UniValue::MappedFile {
+public:
+    /// Opens the file at `path` and maps (or reads) all of it. Throws std::runtime_error if the file cannot be read.
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    [[nodiscard]]
+    const char *data() const noexcept { return ptr; }
+    [[nodiscard]]
+    size_t size() const noexcept { return len; }
+    [[nodiscard]]
+    std::string_view view() const noexcept { return {ptr, len}; }
+
+    /// Returns true if the contents are memory-mapped, as opposed to having been read into a buffer.
+    [[nodiscard]]
+    bool isMapped() const noexcept { return mapped; }
+
+private:
+    const char *ptr = "";
+    size_t len = 0;
+    bool mapped = false;
+    std::string buffer; ///< the contents, if not mapped
+};
+
+/**
+ * A set of paths that selects values of a JSON document, for UniValue::readFiltered().
+ *
+ * Paths are JSON Pointers (RFC 6901), such as "/tx/0/txid": each "/"-separated component is the name of an object
+ * member, or the (decimal) index of an array element, with "~1" standing for '/' and "~0" for '~' within a name. In
+ * addition, a component of "*" matches any member or element. The empty path selects the whole document.
+ *
+ * The paths are compiled into a deterministic automaton, so that the cost of matching a member name or array index
+ * while parsing is a single lookup, however many paths there are.
+ */
+class UniValue::PathFilter {
+public:
+    /// The state that selects nothing, see next()
+    static constexpr size_t npos = size_t(-1);
+
+    /// Compiles `paths`. Throws std::invalid_argument if one of them is not a valid path.
+    explicit PathFilter(const std::vector<std::string_view> &paths);
+    PathFilter(std::initializer_list<std::string_view> paths) : PathFilter(std::vector<std::string_view>(paths)) {}
+
+    /**
+     * The automaton: the state of the root is 0, and next() returns the state of the member named `key` (or of the
+     * element whose decimal index is `key`) of a value in `state`, or npos if nothing within it is selected. All of
+     * the values within a selected value are selected too.
+     */
+    [[nodiscard]]
+    size_t next(size_t state, std::string_view key) const noexcept;
+    [[nodiscard]]
+    bool isSelected(size_t state) const noexcept { return states[state].selected; }
+
+private:
+    struct State {
+        std::vector<std::pair<std::string, size_t>> keys; ///< the state after each key named by a path, sorted by key
+        size_t other = npos; ///< the state after any other key (due to "*")
+        bool selected = false;
+    };
+    std::vector<State> states;
+};
+
+/**
+ * The "shape" of an object: its sequence of keys, along with a precomputed index from each key to its position (slot)
+ * in the sequence.
+ *
+ * JSON data is often made of arrays of records, i.e. objects that all have the same keys in the same order. Looking up
+ * a member of such an object by key with Object::locate() is a linear search, comparing the key with each key before
+ * it. With the shape of the first record, the slot of a key is found once by binary search, after which each record
+ * needs just a single key comparison, to confirm that it has the key in that slot. Objects of any other shape are
+ * still handled correctly (by falling back to Object::locate()), just not as quickly.
+ *
+ *     const UniValue::Shape shape(records[0].get_obj());
+ *     const auto slot = shape.slot("fee"); // or, for a single lookup per object: shape.locate(record, "fee")
+ *     for (const auto &record : records.get_array())
+ *         use(shape.locate(record.get_obj(), "fee", slot));
+ */
+class UniValue::Shape {
+public:
+    Shape() noexcept = default;
+    /// Makes the shape of `obj`.
+    explicit Shape(const Object &obj);
+
+    /// Returns the number of keys.
+    [[nodiscard]]
+    size_t size() const noexcept { return keys.size(); }
+    /// Returns the key in `slot`, which must be less than size().
+    [[nodiscard]]
+    const std::string &key(size_t slot) const noexcept { return keys[slot]; }
+
+    /// Returns the slot of `key` (its first, if it occurs more than once), if it is one of the keys.
+    [[nodiscard]]
+    std::optional<size_t> slot(std::string_view key) const noexcept;
+
+    /// Returns true if `obj` has exactly the keys of this shape, in the same order.
+    [[nodiscard]]
+    bool matches(const Object &obj) const noexcept;
+
+    /**
+     * Returns the same as obj.locate(key), also if `obj` has `key` more than once. If specified, `slot` must be the
+     * result of slot(key), which saves looking it up again.
+     *
+     * Complexity: if `obj` has `key` in the slot predicted by this shape, that key is compared first, and the keys
+     * before it are then checked for an earlier occurrence (up to slot(key) + 1 comparisons, none of them past the
+     * slot). Otherwise linear in the size of `obj`, as Object::locate().
+     */
+    [[nodiscard]]
+    const UniValue *locate(const Object &obj, std::string_view key) const noexcept { return locate(obj, key, slot(key)); }
+    [[nodiscard]]
+    const UniValue *locate(const Object &obj, std::string_view key, std::optional<size_t> slot) const noexcept;
+
+private:
+    std::vector<std::string> keys;
+    std::vector<size_t> sorted; ///< the slots, ordered by their keys (by slot for equal keys)
+};
+
+inline void UniValue::Object::adoptBack() {
+    if (auto *mr = resource())
+        UniValue::adoptResource(vector.back().second, mr);
+}
+
+inline void UniValue::Array::adoptBack() {
+    if (auto *mr = resource())
+        UniValue::adoptResource(vector.back(), mr);
+}
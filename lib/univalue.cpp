@@ -8,13 +8,15 @@
 #define __STDC_FORMAT_MACROS 1
 
 #include <algorithm>
-#include <array>
+#include <atomic>
 #include <cassert>
-#include <cinttypes>
+#include <charconv>
 #include <cstdlib>
 #include <cmath>
 #include <cstdio>
+#include <cstring>
 #include <iomanip>
+#include <limits>
 #include <locale>
 #include <optional>
 #include <sstream>
@@ -31,6 +33,137 @@ struct Defer {
     Defer(Func && f) noexcept : func(std::move(f)) {}
     ~Defer() { func(); }
 };
+
+// Writes the decimal digits of `val` backwards, ending just before `end`, and returns where they begin. This is the
+// same text snprintf("%" PRIu64) would produce, without its locale and format string handling. Digits are produced
+// two at a time from a table, which halves the number of divisions.
+char *FormatDigits(uint64_t val, char *end) noexcept
+{
+    static constexpr char digitPairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    while (val >= 100) {
+        end -= 2;
+        std::memcpy(end, &digitPairs[val % 100 * 2], 2);
+        val /= 100;
+    }
+    if (val >= 10) {
+        end -= 2;
+        std::memcpy(end, &digitPairs[val * 2], 2);
+    } else {
+        *--end = char('0' + val);
+    }
+    return end;
+}
+
+// Writes the fewest significant digits of `val` (which must be finite) that read back as exactly `val` to `digits`,
+// which must have room for 17 of them, without a decimal point or trailing zeros. Returns their count, and sets
+// `exponent` to the decimal exponent of the first digit (e.g. digits "15" with exponent -3 for 0.0015).
+size_t ShortestDigits(double val, char *digits, int &exponent)
+{
+    // In scientific notation, as "d[.ddd]e[+-]xx", whichever way it is made
+    char sci[32];
+    size_t len;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    const auto result = std::to_chars(sci, sci + sizeof(sci), std::fabs(val), std::chars_format::scientific);
+    assert(result.ec == std::errc{});
+    len = size_t(result.ptr - sci);
+#else
+    // Without std::to_chars() for doubles, we must fall back to using the (slower) std::ostringstream: we try 15, 16
+    // and then 17 digits, the last of which always reads back as the same double. (So this may give more digits than
+    // needed, e.g. 15 for the smallest denormal, which needs only 1.)
+    for (int precision = std::numeric_limits<double>::digits10; ; ++precision) {
+        std::ostringstream oss;
+        oss.imbue(std::locale::classic());
+        oss << std::scientific << std::setprecision(precision - 1) << std::fabs(val);
+        const std::string str = oss.str();
+        double readBack;
+        if (precision >= std::numeric_limits<double>::max_digits10
+                || (univalue_internal::ParseDouble(str, &readBack) && readBack == std::fabs(val))) {
+            len = str.copy(sci, sizeof(sci));
+            break;
+        }
+    }
+#endif
+    const char * const e = std::find(sci, sci + len, 'e');
+    size_t n = 0;
+    for (const char *p = sci; p != e; ++p)
+        if (*p != '.')
+            digits[n++] = *p;
+    while (n > 1 && digits[n - 1] == '0') // (the stream pads with zeros)
+        --n;
+    exponent = 0;
+    for (const char *p = e + 2; p != sci + len; ++p) // (past the 'e' and the sign)
+        exponent = exponent * 10 + (*p - '0');
+    if (e[1] == '-')
+        exponent = -exponent;
+    return n;
+}
+
+// Writes `val` to `buf` (which must have room for 32 characters) as JSON text: with `precision` significant digits as
+// by printf("%.*g"), or if `precision` is 0, with the fewest significant digits that read back as the same double, in
+// the notation printf("%.16g") would use. Returns the length written.
+//
+// We can't use snprintf() since the C-locale may be anything, which means the decimal character may be anything.
+// What's more, we can't touch the C-locale since it's a global object and is not thread-safe. See BCHN issue #137.
+size_t FormatDouble(double val, int precision, char *buf)
+{
+    constexpr size_t bufSize = 32; // enough for e.g. "-2.2250738585072014e-308"
+    if (precision) {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        const auto result = std::to_chars(buf, buf + bufSize, val, std::chars_format::general, precision);
+        assert(result.ec == std::errc{});
+        return size_t(result.ptr - buf);
+#else
+        std::ostringstream oss;
+        oss.imbue(std::locale::classic());
+        oss << std::setprecision(precision) << val;
+        const std::string str = oss.str();
+        assert(str.size() <= bufSize);
+        return str.copy(buf, bufSize);
+#endif
+    }
+    char digits[std::numeric_limits<double>::max_digits10];
+    int exponent;
+    const size_t n = ShortestDigits(val, digits, exponent);
+    char *p = buf;
+    if (std::signbit(val))
+        *p++ = '-';
+    if (exponent < -4 || exponent >= 16) {
+        // Scientific, as "d[.ddd]e[+-]xx"
+        *p++ = digits[0];
+        if (n > 1) {
+            *p++ = '.';
+            p = std::copy(digits + 1, digits + n, p);
+        }
+        *p++ = 'e';
+        *p++ = exponent < 0 ? '-' : '+';
+        const unsigned absExponent = unsigned(exponent < 0 ? -exponent : exponent);
+        if (absExponent < 10)
+            *p++ = '0'; // (at least 2 digits, as printf() writes)
+        p += absExponent < 10 ? 1 : absExponent < 100 ? 2 : 3;
+        FormatDigits(absExponent, p);
+    } else if (exponent < 0) {
+        // "0.000ddd"
+        *p++ = '0';
+        *p++ = '.';
+        p = std::fill_n(p, -exponent - 1, '0');
+        p = std::copy(digits, digits + n, p);
+    } else {
+        // The integer digits (padded with zeros), then the fractional ones, if any
+        const size_t intDigits = size_t(exponent) + 1;
+        p = std::copy(digits, digits + std::min(n, intDigits), p);
+        if (n > intDigits) {
+            *p++ = '.';
+            p = std::copy(digits + intDigits, digits + n, p);
+        } else {
+            p = std::fill_n(p, intDigits - n, '0');
+        }
+    }
+    assert(size_t(p - buf) <= bufSize);
+    return size_t(p - buf);
+}
 }
 
 /* static */ const UniValue UniValue::Null{VNULL};
@@ -166,22 +299,87 @@ void UniValue::setNumStr(const char* val_)
     }
 }
 
+UniValue::UniValue(const UniValue& o, std::pmr::memory_resource *mr)
+{
+    o.var.visit(univalue_detail::visitor{
+        [&](const Object &obj) {
+            Object &dst = var.emplace<Object>(mr);
+            dst.reserve(obj.size());
+            for (const auto &[key, value] : obj)
+                dst.emplace_back(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(value, mr));
+        },
+        [&](const Array &arr) {
+            Array &dst = var.emplace<Array>(mr);
+            dst.reserve(arr.size());
+            for (const auto &value : arr)
+                dst.emplace_back(value, mr);
+        },
+        [&](const auto &alt) { var = alt; },
+    });
+}
+
+UniValue::UniValue(UniValue&& o, std::pmr::memory_resource *mr)
+{
+    // Containers that already use `mr` are moved as-is, but may hold values that do not (if `mr` is nullptr, or if
+    // they were modified in place), so we still need to descend into them.
+    o.var.visit(univalue_detail::visitor{
+        [&](Object &obj) {
+            if (obj.resource() == mr) {
+                var.emplace<Object>(std::move(obj));
+                reallocateChildren(mr);
+                return;
+            }
+            Object &dst = var.emplace<Object>(mr);
+            dst.reserve(obj.size());
+            for (auto &[key, value] : obj)
+                dst.emplace_back(std::piecewise_construct, std::forward_as_tuple(std::move(key)),
+                                 std::forward_as_tuple(std::move(value), mr));
+        },
+        [&](Array &arr) {
+            if (arr.resource() == mr) {
+                var.emplace<Array>(std::move(arr));
+                reallocateChildren(mr);
+                return;
+            }
+            Array &dst = var.emplace<Array>(mr);
+            dst.reserve(arr.size());
+            for (auto &value : arr)
+                dst.emplace_back(std::move(value), mr);
+        },
+        [&](auto &alt) { var = std::move(alt); },
+    });
+}
+
+void UniValue::reallocate(std::pmr::memory_resource *mr)
+{
+    UniValue tmp(std::move(*this), mr);
+    setNull(); // so that the assignment below move-constructs (keeping `mr`) rather than move-assigns
+    *this = std::move(tmp);
+}
+
+void UniValue::reallocateChildren(std::pmr::memory_resource *mr)
+{
+    const auto Fix = [mr](UniValue &child) {
+        if (!child.var.holds_alternative<Object>() && !child.var.holds_alternative<Array>())
+            return;
+        if (child.resource() != mr)
+            child.reallocate(mr);
+        else
+            child.reallocateChildren(mr);
+    };
+    var.visit(univalue_detail::visitor{
+        [&](Object &obj) { for (auto &entry : obj) Fix(entry.second); },
+        [&](Array &arr) { for (auto &value : arr) Fix(value); },
+        [](auto &) {},
+    });
+}
+
 template<typename Int64>
 void UniValue::setInt64(Int64 val_)
 {
     static_assert(std::is_same_v<Int64, int64_t> || std::is_same_v<Int64, uint64_t>,
                   "This function may only be called with either an int64_t or a uint64_t argument.");
-    // Begin by setting to null, so that null is assigned if the number cannot be accepted.
-    setNull();
-    // Longest possible 64-bit integers are "-9223372036854775808" and "18446744073709551615",
-    // both of which require 20 visible characters and 1 terminating null,
-    // hence buffer size 21.
-    constexpr int bufSize = 21;
-    std::array<char, bufSize> buf;
-    int n = std::snprintf(buf.data(), size_t(bufSize), std::is_signed<Int64>::value ? "%" PRId64 : "%" PRIu64, val_);
-    if (n <= 0 || n >= bufSize) // should never happen
-        return;
-    var.emplace<NumStr>(buf.data(), std::string::size_type(n));
+    var.emplace<NumBin>(val_);
 }
 
 void UniValue::operator=(short val_) { setInt64<int64_t>(val_); }
@@ -193,24 +391,84 @@ void UniValue::operator=(unsigned val_) { setInt64<uint64_t>(val_); }
 void UniValue::operator=(unsigned long val_) { setInt64<uint64_t>(val_); }
 void UniValue::operator=(unsigned long long val_) { setInt64<uint64_t>(val_); }
 
-void UniValue::operator=(double val_)
+void UniValue::operator=(double val_) { setReal(val_, RealFormat::Legacy16); }
+
+void UniValue::setReal(double val_, RealFormat format)
 {
-    // Begin by setting to null, so that null is assigned if the number cannot be accepted.
-    setNull();
-    // Ensure not NaN or inf, which are not representable by the JSON Number type.
-    if (!std::isfinite(val_))
+    // Ensure not NaN or inf, which are not representable by the JSON Number type. Null is assigned instead.
+    if (!std::isfinite(val_)) {
+        setNull();
         return;
-    // For floats and doubles, we can't use snprintf() since the C-locale may be anything,
-    // which means the decimal character may be anything. What's more, we can't touch the
-    // C-locale since it's a global object and is not thread-safe.
-    //
-    // So, for doubles we must fall-back to using the (slower) std::ostringstream.
-    // See BCHN issue #137.
-    std::ostringstream oss;
-    oss.imbue(std::locale::classic());
-    if (oss << std::setprecision(16) << val_) {
-        var.emplace<NumStr>(oss.str());
     }
+    var.emplace<NumBin>(val_, format);
+}
+
+void UniValue::setFixed(int64_t scaled, unsigned decimals)
+{
+    if (decimals > NumBin::maxFixedDecimals)
+        throw std::runtime_error("UniValue::setFixed: more than 18 decimals");
+    var.emplace<NumBin>(scaled, uint8_t(decimals));
+}
+
+std::string_view UniValue::NumBin::format(char (&buf)[maxTextLen]) const
+{
+    if (const std::string *s = text.load(std::memory_order_acquire))
+        return *s;
+    char *begin, * const end = buf + maxTextLen;
+    switch (kind) {
+    case Int:
+        // (0 - uint64_t(i) is the magnitude of i even for INT64_MIN, whose negation does not fit an int64_t)
+        begin = FormatDigits(val.i < 0 ? 0 - uint64_t(val.i) : uint64_t(val.i), end);
+        if (val.i < 0)
+            *--begin = '-';
+        return std::string_view(begin, size_t(end - begin));
+    case UInt:
+        begin = FormatDigits(val.u, end);
+        return std::string_view(begin, size_t(end - begin));
+    case Real:
+        return std::string_view(buf, FormatDouble(val.d, 0, buf));
+    case Real16:
+        return std::string_view(buf, FormatDouble(val.d, 16, buf));
+    case Fixed: {
+        // The integer part, then exactly `decimals` digits (including any leading zeros) of the fractional part
+        uint64_t magnitude = val.i < 0 ? 0 - uint64_t(val.i) : uint64_t(val.i);
+        begin = end;
+        if (decimals) {
+            for (unsigned i = 0; i < decimals; ++i, magnitude /= 10)
+                *--begin = char('0' + magnitude % 10);
+            *--begin = '.';
+        }
+        begin = FormatDigits(magnitude, begin);
+        if (val.i < 0)
+            *--begin = '-';
+        return std::string_view(begin, size_t(end - begin));
+    }
+    }
+    return {};
+}
+
+const std::string &UniValue::NumBin::str() const
+{
+    if (const std::string *s = text.load(std::memory_order_acquire))
+        return *s;
+    char buf[maxTextLen];
+    const std::string *made = new std::string(format(buf));
+    // Another thread may have made the string at the same time, in which case we use theirs.
+    const std::string *expected = nullptr;
+    if (!text.compare_exchange_strong(expected, made, std::memory_order_acq_rel, std::memory_order_acquire)) {
+        delete made;
+        return *expected;
+    }
+    return *made;
+}
+
+bool UniValue::NumBin::operator==(const NumBin &o) const
+{
+    // (only with 16 digits may different doubles have the same text)
+    if (kind == o.kind && kind != Real16 && decimals == o.decimals)
+        return val.u == o.val.u;
+    char buf[maxTextLen], otherBuf[maxTextLen];
+    return format(buf) == o.format(otherBuf);
 }
 
 const UniValue& UniValue::operator[](std::string_view key) const noexcept
@@ -328,3 +586,45 @@ std::string UniValue::typeName(int t) {
     appendTypeNameIfTypeIncludes(UniValue::VSTR);
     return result;
 }
+
+UniValue::Shape::Shape(const Object &obj)
+{
+    keys.reserve(obj.size());
+    for (const auto &entry : obj)
+        keys.push_back(entry.first);
+    sorted.resize(keys.size());
+    for (size_t i = 0; i < sorted.size(); ++i)
+        sorted[i] = i;
+    std::stable_sort(sorted.begin(), sorted.end(), [this](size_t a, size_t b) { return keys[a] < keys[b]; });
+}
+
+std::optional<size_t> UniValue::Shape::slot(std::string_view key) const noexcept
+{
+    const auto it = std::lower_bound(sorted.begin(), sorted.end(), key,
+                                     [this](size_t slot, std::string_view k) { return keys[slot] < k; });
+    if (it != sorted.end() && keys[*it] == key)
+        return *it;
+    return std::nullopt;
+}
+
+bool UniValue::Shape::matches(const Object &obj) const noexcept
+{
+    return obj.size() == keys.size()
+           && std::equal(obj.begin(), obj.end(), keys.begin(),
+                         [](const Object::value_type &entry, const std::string &key) { return entry.first == key; });
+}
+
+const UniValue *UniValue::Shape::locate(const Object &obj, std::string_view key, std::optional<size_t> slot) const noexcept
+{
+    if (slot && *slot < obj.size()) {
+        const auto predicted = obj.begin() + *slot;
+        // Only an object of another shape may also have `key` before the predicted slot, and then it is that earlier
+        // member which Object::locate() returns. This compares the keys before the slot only if the slot holds `key`.
+        if (predicted->first == key) {
+            const auto it = std::find_if(obj.begin(), predicted,
+                                         [key](const Object::value_type &entry) { return entry.first == key; });
+            return &it->second; // (`predicted` itself, if no earlier member has `key`)
+        }
+    }
+    return obj.locate(key);
+}
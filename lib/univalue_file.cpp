@@ -0,0 +1,85 @@
+// Copyright (c) 2026 Calin A. Culianu <calin.culianu@gmail.com>
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://opensource.org/licenses/mit-license.php.
+
+#include "univalue.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define UNIVALUE_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+[[noreturn]] void ThrowCannotRead(const std::string &path, int err)
+{
+    throw std::runtime_error("UniValue::MappedFile: cannot read " + path + (err ? ": " + std::string(std::strerror(err))
+                                                                               : std::string()));
+}
+} // namespace
+
+UniValue::MappedFile::MappedFile(const std::string &path)
+{
+#ifdef UNIVALUE_HAVE_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        ThrowCannotRead(path, errno);
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+        flags |= MAP_POPULATE; // fault all of the pages in now, rather than one at a time as the parser gets to them
+#endif
+        void * const p = ::mmap(nullptr, size_t(st.st_size), PROT_READ, flags, fd, 0);
+        if (p != MAP_FAILED) {
+#ifdef MADV_SEQUENTIAL
+            ::madvise(p, size_t(st.st_size), MADV_SEQUENTIAL); // just a hint, so failure does not matter
+#endif
+            ::close(fd);
+            ptr = static_cast<const char *>(p);
+            len = size_t(st.st_size);
+            mapped = true;
+            return;
+        }
+    }
+    // Not a regular file (or empty, or cannot be mapped): read it instead
+    char buf[65536];
+    for (;;) {
+        const ssize_t n = ::read(fd, buf, sizeof(buf));
+        if (n > 0) {
+            buffer.append(buf, size_t(n));
+        } else if (n == 0) {
+            break;
+        } else if (errno != EINTR) {
+            const int err = errno;
+            ::close(fd);
+            ThrowCannotRead(path, err);
+        }
+    }
+    ::close(fd);
+#else
+    std::ifstream file(path, std::ios::binary);
+    buffer.assign(std::istreambuf_iterator<char>(file), {});
+    if (!file.is_open() || file.bad())
+        ThrowCannotRead(path, 0);
+#endif
+    ptr = buffer.data();
+    len = buffer.size();
+}
+
+UniValue::MappedFile::~MappedFile()
+{
+#ifdef UNIVALUE_HAVE_MMAP
+    if (mapped)
+        ::munmap(const_cast<char *>(ptr), len);
+#endif
+}
@@ -8,7 +8,12 @@
 #include "univalue.h"
 #include "univalue_internal.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <limits>
 #include <stdexcept>
+#include <string>
+#include <type_traits>
 
 bool UniValue::get_bool() const
 {
@@ -17,53 +22,161 @@ bool UniValue::get_bool() const
     return getBool();
 }
 
-int UniValue::get_int() const
+namespace {
+/// Returns whether `val` is within the range of Integer.
+template <typename Integer, typename Int64>
+constexpr bool InRange(Int64 val) noexcept
 {
-    if (!isNum())
-        throw std::runtime_error("JSON value is not an integer as expected");
-    int retval;
-    if (!univalue_internal::ParseInt(getValStr(), &retval))
-        throw std::runtime_error("JSON integer out of range");
-    return retval;
+    if constexpr (std::is_signed_v<Int64>) {
+        if (val < 0) {
+            if constexpr (std::is_signed_v<Integer>)
+                return val >= std::numeric_limits<Integer>::min();
+            else
+                return false;
+        }
+    }
+    return uint64_t(val) <= uint64_t(std::numeric_limits<Integer>::max());
 }
+} // namespace
 
-unsigned UniValue::get_uint() const
+template <typename T>
+bool UniValue::toNumber(T *out) const
 {
     if (!isNum())
-        throw std::runtime_error("JSON value is not an integer as expected");
-    unsigned retval;
-    if (!univalue_internal::ParseUInt(getValStr(), &retval))
-        throw std::runtime_error("JSON unsigned integer out of range");
-    return retval;
+        return false;
+    if (var.holds_alternative<NumBin>()) {
+        const NumBin &num = var.get<NumBin>();
+        if constexpr (std::is_same_v<T, double>) {
+            // Converting an integer rounds it the same as parsing its text would, and a double written in the shortest
+            // form reads back as itself. With 16 digits, however, the text may not read back as the double assigned,
+            // and it is the value of the text that is returned (as before).
+            if (num.kind == NumBin::Int || num.kind == NumBin::UInt || num.kind == NumBin::Real) {
+                *out = num.kind == NumBin::Int    ? double(num.val.i)
+                       : num.kind == NumBin::UInt ? double(num.val.u)
+                                                  : num.val.d;
+                return true;
+            }
+        } else {
+            // Integers held in binary need no parsing. Doubles still go through their text, so that exactly the same
+            // values are accepted (e.g. 5.0, written as "5") as before.
+            if (num.kind == NumBin::Int) {
+                if (!InRange<T>(num.val.i))
+                    return false;
+                *out = T(num.val.i);
+                return true;
+            }
+            if (num.kind == NumBin::UInt) {
+                if (!InRange<T>(num.val.u))
+                    return false;
+                *out = T(num.val.u);
+                return true;
+            }
+        }
+    }
+    if constexpr (std::is_same_v<T, int>)
+        return univalue_internal::ParseInt(getValStr(), out);
+    else if constexpr (std::is_same_v<T, unsigned>)
+        return univalue_internal::ParseUInt(getValStr(), out);
+    else if constexpr (std::is_same_v<T, int64_t>)
+        return univalue_internal::ParseInt64(getValStr(), out);
+    else if constexpr (std::is_same_v<T, uint64_t>)
+        return univalue_internal::ParseUInt64(getValStr(), out);
+    else
+        return univalue_internal::ParseDouble(getValStr(), out);
 }
 
-int64_t UniValue::get_int64() const
+template <typename Integer>
+Integer UniValue::getInt(const char *rangeError) const
 {
     if (!isNum())
         throw std::runtime_error("JSON value is not an integer as expected");
-    int64_t retval;
-    if (!univalue_internal::ParseInt64(getValStr(), &retval))
-        throw std::runtime_error("JSON integer out of range");
+    Integer retval;
+    if (!toNumber(&retval))
+        throw std::runtime_error(rangeError);
     return retval;
 }
 
-uint64_t UniValue::get_uint64() const
+int UniValue::get_int() const { return getInt<int>("JSON integer out of range"); }
+unsigned UniValue::get_uint() const { return getInt<unsigned>("JSON unsigned integer out of range"); }
+int64_t UniValue::get_int64() const { return getInt<int64_t>("JSON integer out of range"); }
+uint64_t UniValue::get_uint64() const { return getInt<uint64_t>("JSON unsigned integer out of range"); }
+
+double UniValue::get_real() const
 {
     if (!isNum())
-        throw std::runtime_error("JSON value is not an integer as expected");
-    uint64_t retval;
-    if (!univalue_internal::ParseUInt64(getValStr(), &retval))
-        throw std::runtime_error("JSON unsigned integer out of range");
+        throw std::runtime_error("JSON value is not a number as expected");
+    double retval;
+    if (!toNumber(&retval))
+        throw std::runtime_error("JSON double out of range");
     return retval;
 }
 
-double UniValue::get_real() const
+template <typename T>
+UniValue::size_type UniValue::Array::toNumbers(T *out, size_type count) const
+{
+    count = std::min(count, vector.size());
+    for (size_type i = 0; i < count; ++i) {
+        if constexpr (std::is_integral_v<T>) {
+            // Numbers read from JSON text hold that text, which was already validated by the reader: parse it straight
+            // away with the SWAR digit parser, skipping toNumber()'s dispatch on the kind of value and ParseInt()'s
+            // prechecks. Only forms it does not handle (e.g. "1e3") take the full path below.
+            const UniValue &uv = vector[i];
+            if (uv.var.holds_alternative<NumStr>()) {
+                if (const auto ok = univalue_internal::GenericParseIntFast(std::string_view(uv.var.get<NumStr>()),
+                                                                           out + i)) {
+                    if (!*ok)
+                        return i;
+                    continue;
+                }
+            }
+        }
+        if (!vector[i].toNumber(out + i))
+            return i;
+    }
+    return count;
+}
+
+auto UniValue::Array::to_numbers(int *out, size_type count) const -> size_type { return toNumbers(out, count); }
+auto UniValue::Array::to_numbers(unsigned *out, size_type count) const -> size_type { return toNumbers(out, count); }
+auto UniValue::Array::to_numbers(int64_t *out, size_type count) const -> size_type { return toNumbers(out, count); }
+auto UniValue::Array::to_numbers(uint64_t *out, size_type count) const -> size_type { return toNumbers(out, count); }
+auto UniValue::Array::to_numbers(double *out, size_type count) const -> size_type { return toNumbers(out, count); }
+
+void UniValue::Array::throwNotNumber(size_type index)
+{
+    throw std::runtime_error("JSON array value at index " + std::to_string(index)
+                             + " is not a number as expected, or is out of range");
+}
+
+int64_t UniValue::get_fixed(unsigned decimals) const
 {
     if (!isNum())
         throw std::runtime_error("JSON value is not a number as expected");
-    double retval;
-    if (!univalue_internal::ParseDouble(getValStr(), &retval))
-        throw std::runtime_error("JSON double out of range");
+    if (decimals > NumBin::maxFixedDecimals)
+        throw std::runtime_error("JSON fixed-point number requested with more than 18 decimals");
+    using univalue_internal::FixedResult;
+    FixedResult result;
+    int64_t retval{};
+    // value * 10^exponent, scaled
+    const auto ScaleSigned = [&](int64_t value, int exponent) {
+        return univalue_internal::ScaleFixed(value < 0, value < 0 ? 0 - uint64_t(value) : uint64_t(value), exponent,
+                                             decimals, &retval);
+    };
+    const NumBin *num = var.holds_alternative<NumBin>() ? &var.get<NumBin>() : nullptr;
+    if (num && num->kind == NumBin::Int)
+        result = ScaleSigned(num->val.i, 0);
+    else if (num && num->kind == NumBin::UInt)
+        result = univalue_internal::ScaleFixed(false, num->val.u, 0, decimals, &retval);
+    else if (num && num->kind == NumBin::Fixed)
+        result = ScaleSigned(num->val.i, -int(num->decimals));
+    else // the text, including that of a double
+        result = univalue_internal::ParseFixed(getValStr(), decimals, &retval);
+    switch (result) {
+    case FixedResult::Ok: break;
+    case FixedResult::NotANumber: throw std::runtime_error("JSON value is not a number as expected");
+    case FixedResult::OutOfRange: throw std::runtime_error("JSON fixed-point number out of range");
+    case FixedResult::TooPrecise: throw std::runtime_error("JSON fixed-point number has too many decimals");
+    }
     return retval;
 }
 
@@ -5,8 +5,12 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
+#include <limits>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <type_traits>
 
 /// Definitions and functions used internally by the UniValue library
 namespace univalue_internal {
@@ -16,4 +20,86 @@ extern bool ParseUInt(const std::string& str, unsigned *out) noexcept;
 extern bool ParseInt64(const std::string& str, int64_t *out) noexcept;
 extern bool ParseUInt64(const std::string& str, uint64_t *out) noexcept;
 extern bool ParseDouble(const std::string& str, double *out);
+
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+/// Returns whether the 8 characters loaded (little-endian) into `chunk` are all decimal digits.
+inline constexpr bool IsEightDigits(uint64_t chunk) noexcept
+{
+    return ((chunk & 0xF0F0F0F0F0F0F0F0) | (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4))
+           == 0x3333333333333333;
+}
+
+/// Returns the value of the 8 decimal digits loaded (little-endian) into `chunk`, combining adjacent digits into
+/// 2-digit, then 4-digit, then the 8-digit number with 3 multiplications rather than 8.
+inline constexpr uint32_t ParseEightDigits(uint64_t chunk) noexcept
+{
+    chunk = ((chunk & 0x0F0F0F0F0F0F0F0F) * (1 + (10 << 8))) >> 8;
+    chunk = ((chunk & 0x00FF00FF00FF00FF) * (1 + (100 << 16))) >> 16;
+    return uint32_t(((chunk & 0x0000FFFF0000FFFF) * (1 + (10000ULL << 32))) >> 32);
+}
+#define UNIVALUE_HAVE_SWAR_DIGITS 1
+#endif
+
+/// Parses `str` if it is an optional '-' followed by nothing but decimal digits, which includes every integer in JSON
+/// text: the digits are read 8 at a time where possible (SWAR), without strtoll(), errno or the locale. Returns
+/// whether `str` is a valid Integer, or nothing if `str` has any other form, which is then left to strtoll(). Also
+/// called directly by UniValue::Array::to_numbers() on the text of each element.
+template <typename Integer>
+inline std::optional<bool> GenericParseIntFast(std::string_view str, Integer *out) noexcept
+{
+    const char *p = str.data(), * const end = p + str.size();
+    const bool negative = p != end && *p == '-';
+    p += negative;
+    if (p == end)
+        return std::nullopt;
+    while (*p == '0' && p + 1 != end) // strtoll() allows any number of leading zeros
+        ++p;
+    if (end - p > std::numeric_limits<uint64_t>::digits10 + 1)
+        return std::nullopt; // (too long to be in range, if it is all digits)
+    uint64_t magnitude = 0;
+#ifdef UNIVALUE_HAVE_SWAR_DIGITS
+    for (uint64_t chunk; end - p >= 8; p += 8) {
+        std::memcpy(&chunk, p, 8);
+        if (!IsEightDigits(chunk))
+            return std::nullopt;
+        magnitude = magnitude * 100'000'000 + ParseEightDigits(chunk); // (at most 16 digits so far)
+    }
+#endif
+    for (; p != end; ++p) {
+        const unsigned digit = unsigned(*p) - '0';
+        if (digit > 9)
+            return std::nullopt;
+        if (magnitude > (std::numeric_limits<uint64_t>::max() - digit) / 10)
+            return false; // out of range for any integer type
+        magnitude = magnitude * 10 + digit;
+    }
+    if constexpr (std::is_signed_v<Integer>) {
+        if (negative) {
+            // (the magnitude of the minimum is 1 more than the maximum)
+            if (magnitude > uint64_t(std::numeric_limits<Integer>::max()) + 1)
+                return false;
+            if (out) *out = magnitude ? Integer(-Integer(magnitude - 1) - 1) : 0;
+            return true;
+        }
+    } else {
+        if (negative) {
+            // "-0" is accepted, but not any other negative number (nor even "-00")
+            if (str.size() != 2 || magnitude)
+                return false;
+            if (out) *out = 0;
+            return true;
+        }
+    }
+    if (magnitude > uint64_t(std::numeric_limits<Integer>::max()))
+        return false;
+    if (out) *out = Integer(magnitude);
+    return true;
+}
+
+/// The result of ParseFixed() and ScaleFixed()
+enum class FixedResult { Ok, NotANumber, OutOfRange, TooPrecise };
+/// Sets *out to the JSON number `str` multiplied by 10^decimals, exactly (see UniValue::get_fixed()).
+extern FixedResult ParseFixed(std::string_view str, unsigned decimals, int64_t *out) noexcept;
+/// Sets *out to (negative ? -1 : 1) * magnitude * 10^(exponent + decimals), if this is an int64_t.
+extern FixedResult ScaleFixed(bool negative, uint64_t magnitude, int exponent, unsigned decimals, int64_t *out) noexcept;
 } // namespace univalue_internal
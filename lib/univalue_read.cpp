@@ -6,18 +6,29 @@
 
 #include "univalue.h"
 #include "univalue_internal.h"
+#include "univalue_simd.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
+#include <charconv>
+#include <condition_variable>
+#include <cfloat>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <deque>
+#include <exception>
+#include <future>
 #include <limits>
+#include <map>
+#include <mutex>
 #include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <type_traits>
 #include <vector>
@@ -37,8 +48,8 @@ inline constexpr bool json_isdigit(char ch) noexcept
     return ch >= '0' && ch <= '9';
 }
 
-// Attention: in several functions below, you are reading a NUL-terminated string.
-// Always assure yourself that a character is not NUL, prior to advancing the pointer to the next character.
+// Attention: in several functions below, you are reading a length-delimited buffer, which is *not* NUL-terminated.
+// Always assure yourself that the pointer is not at the end of the buffer, prior to dereferencing it.
 
 /**
  * Helper for getJsonToken; converts hexadecimal string to unsigned integer.
@@ -48,14 +59,16 @@ inline constexpr bool json_isdigit(char ch) noexcept
  *
  * On success, returns an optional containing the converted codepoint.
  *
- * Consumes the first 4 hex characters in `buffer`, insofar they exist.
+ * Consumes the first 4 hex characters in `buffer`, insofar they exist before `end`.
  */
-inline constexpr std::optional<unsigned> hatoui(const char*& buffer) noexcept
+inline constexpr std::optional<unsigned> hatoui(const char*& buffer, const char* end) noexcept
 {
     unsigned val = 0;
-    for (const char* end = buffer + 4; buffer != end; ++buffer) {  // consume 4 chars from buffer
+    for (const char* stop = buffer + 4; buffer != stop; ++buffer) {  // consume 4 chars from buffer
         val *= 16;
-        if (json_isdigit(*buffer))
+        if (buffer == end)
+            return std::nullopt; // premature end of buffer, fail
+        else if (json_isdigit(*buffer))
             val += *buffer - '0';
         else if (*buffer >= 'a' && *buffer <= 'f')
             val += *buffer - 'a' + 10;
@@ -67,14 +80,27 @@ inline constexpr std::optional<unsigned> hatoui(const char*& buffer) noexcept
     return val;
 }
 
+/**
+ * A stand-in for the std::string that getJsonToken() unescapes strings into, for when only their validity matters: it
+ * discards everything written to it (and so never allocates).
+ */
+struct NullString {
+    void push_back(char) noexcept {}
+    void assign(const char *, const char *) noexcept {}
+    void clear() noexcept {}
+    operator std::string_view() const noexcept { return {}; }
+};
+
 /**
  * Filter that generates and validates UTF-8, as well as collates UTF-16
- * surrogate pairs as specified in RFC4627.
+ * surrogate pairs as specified in RFC4627. The output is written to a
+ * std::string, or to a NullString when only validating.
  */
+template <typename String>
 class JSONUTF8StringFilter
 {
 public:
-    explicit JSONUTF8StringFilter(std::string &s) : str(s) {}
+    explicit JSONUTF8StringFilter(String &s) : str(s) {}
     // Write single 8-bit char (may be part of UTF-8 sequence)
     void push_back(unsigned char ch)
     {
@@ -136,7 +162,7 @@ public:
         return is_valid;
     }
 private:
-    std::string &str;
+    String &str;
     bool is_valid = true;
     // Current UTF-8 decoding state
     unsigned int codepoint = 0;
@@ -190,24 +216,6 @@ enum jtokentype {
     JTOK_STRING,
 };
 
-[[nodiscard]]
-inline constexpr bool jsonTokenIsValue(jtokentype jtt) noexcept
-{
-    switch (jtt) {
-    case JTOK_KW_NULL:
-    case JTOK_KW_TRUE:
-    case JTOK_KW_FALSE:
-    case JTOK_NUMBER:
-    case JTOK_STRING:
-        return true;
-
-    default:
-        return false;
-    }
-
-    // not reached
-}
-
 [[nodiscard]]
 inline constexpr bool json_isspace(int ch) noexcept
 {
@@ -225,18 +233,33 @@ inline constexpr bool json_isspace(int ch) noexcept
     // not reached
 }
 
-jtokentype getJsonToken(std::string& tokenVal, const char*& buffer)
+/// Reads the next token from [buffer, end), advancing `buffer` past it. On error, `buffer` is left pointing at the
+/// offending character (or at `end` if the buffer ended prematurely).
+///
+/// For JTOK_NUMBER and JTOK_STRING, `tokenVal` is set to the value of the token, so that the caller may construct it
+/// directly in its final place. This is a view into the input buffer itself where possible (numbers, and strings
+/// without escapes), otherwise it is a view of `scratch`, which then holds the unescaped string. `scratch` is only
+/// ever used as a work area, so that a caller may reuse it (along with its capacity) across calls. If `scratch` is a
+/// NullString, the token is validated just the same, but `tokenVal` is empty for strings with escapes.
+template <typename String>
+jtokentype getJsonToken(std::string_view& tokenVal, String& scratch, const char*& buffer, const char* const end)
 {
-    tokenVal.clear();
-
-    while (json_isspace(*buffer))          // skip whitespace
-        ++buffer;
+    tokenVal = {};
 
-    switch (*buffer) {
+    if (buffer != end && json_isspace(*buffer)) {          // skip whitespace
+        // Runs of more than one whitespace character (i.e. indentation) are skipped in bulk
+        if (buffer + 1 != end && json_isspace(buffer[1]))
+            buffer = univalue_internal::simd().skipWhitespace(buffer + 2, end);
+        else
+            ++buffer;
+    }
 
-    case '\0': // terminating NUL
+    if (buffer == end) // end of buffer
         return JTOK_NONE;
 
+    // Note: an embedded NUL, like any other unexpected character, is handled by the `default:` case below
+    switch (*buffer) {
+
     case '{':
         ++buffer;
         return JTOK_OBJ_OPEN;
@@ -258,19 +281,20 @@ jtokentype getJsonToken(std::string& tokenVal, const char*& buffer)
         return JTOK_COMMA;
 
     case 'n': // null
-        if (*++buffer == 'u' && *++buffer == 'l' && *++buffer == 'l') {
+        if (++buffer != end && *buffer == 'u' && ++buffer != end && *buffer == 'l' && ++buffer != end && *buffer == 'l') {
             ++buffer;
             return JTOK_KW_NULL;
         }
         return JTOK_ERR;
     case 't': // true
-        if (*++buffer == 'r' && *++buffer == 'u' && *++buffer == 'e') {
+        if (++buffer != end && *buffer == 'r' && ++buffer != end && *buffer == 'u' && ++buffer != end && *buffer == 'e') {
             ++buffer;
             return JTOK_KW_TRUE;
         }
         return JTOK_ERR;
     case 'f': // false
-        if (*++buffer == 'a' && *++buffer == 'l' && *++buffer == 's' && *++buffer == 'e') {
+        if (++buffer != end && *buffer == 'a' && ++buffer != end && *buffer == 'l' && ++buffer != end && *buffer == 's'
+                && ++buffer != end && *buffer == 'e') {
             ++buffer;
             return JTOK_KW_FALSE;
         }
@@ -287,65 +311,66 @@ jtokentype getJsonToken(std::string& tokenVal, const char*& buffer)
     case '7':
     case '8':
     case '9': {
+        const auto isDigitAt = [end](const char *p) { return p != end && json_isdigit(*p); };
+
         // part 1: int
         const char * const first = buffer;
         const bool firstIsMinus = *first == '-';
 
         const char * const firstDigit = first + firstIsMinus;
 
-        if (*firstDigit == '0' && json_isdigit(firstDigit[1]))
+        if (firstDigit != end && *firstDigit == '0' && isDigitAt(firstDigit + 1))
             return JTOK_ERR;
 
         ++buffer;                                                       // consume first char
 
-        if (firstIsMinus && !json_isdigit(*buffer)) {
+        if (firstIsMinus && !isDigitAt(buffer)) {
             // reject buffers ending in '-' or '-' followed by non-digit
             return JTOK_ERR;
         }
 
-        while (json_isdigit(*buffer)) {                      // consume digits
+        while (isDigitAt(buffer)) {                      // consume digits
             ++buffer;
         }
 
         // part 2: frac
-        if (*buffer == '.') {
+        if (buffer != end && *buffer == '.') {
             ++buffer;                                                   // consume .
 
-            if (!json_isdigit(*buffer))
+            if (!isDigitAt(buffer))
                 return JTOK_ERR;
             do {                                                                       // consume digits
                 ++buffer;
-            } while (json_isdigit(*buffer));
+            } while (isDigitAt(buffer));
         }
 
         // part 3: exp
-        if (*buffer == 'e' || *buffer == 'E') {
+        if (buffer != end && (*buffer == 'e' || *buffer == 'E')) {
             ++buffer;                                                   // consume E
 
-            if (*buffer == '-' || *buffer == '+') { // consume +/-
+            if (buffer != end && (*buffer == '-' || *buffer == '+')) { // consume +/-
                 ++buffer;
             }
 
-            if (!json_isdigit(*buffer))
+            if (!isDigitAt(buffer))
                 return JTOK_ERR;
             do {                                                                       // consume digits
                 ++buffer;
-            } while (json_isdigit(*buffer));
+            } while (isDigitAt(buffer));
         }
 
-        tokenVal.assign(first, buffer);
+        tokenVal = std::string_view(first, buffer - first);
         return JTOK_NUMBER;
         }
 
     case '"': {
-        constexpr size_t reserveSize = 0; // set to 0 to not pre-alloc anything
         ++buffer;  // skip "
 
         // First, try the fast path which doesn't use the (slow) JSONUTF8StringFilter.
         // This is a common-case optimization: we optimistically scan to ensure string
         // is a simple ascii string with no unicode and no escapes, and if so, return it.
         // If we do encounter non-ascii or escapes, we accept the partial string into
-        // `tokenVal`, then we proceed to the slow path.  In most real-world JSON, the
+        // `scratch`, then we proceed to the slow path.  In most real-world JSON, the
         // fast path below is the only path taken and is the common-case.
         constexpr bool tryFastPath = true;
         if constexpr (tryFastPath) {
@@ -353,37 +378,47 @@ jtokentype getJsonToken(std::string& tokenVal, const char*& buffer)
                 Processed, NotFullyProcessed, Error
             };
 
-            static const auto FastPathParseSimpleString = [](const char *& raw) -> FastPath {
-                for (; *raw; ++raw) {
-                    const uint8_t ch = static_cast<uint8_t>(*raw);
-                    if (ch == '"') {
-                        // fast-path accept case: simple string end at " char
-                        return FastPath::Processed;
-                    } else if (ch == '\\') {
-                        // has escapes -- cannot process as simple string, must continue using slow path
+            static const auto FastPathParseSimpleString = [](const char *& raw, const char *end) -> FastPath {
+                // Skip over the run of plain characters in bulk (this is SIMD-accelerated where available),
+                // landing on the first character that needs to be examined.
+                const univalue_internal::SimdKernels &kernels = univalue_internal::simd();
+                raw = kernels.findStringSpecial(raw, end);
+                if (raw == end) {
+                    // premature end of buffer
+                    return FastPath::Error;
+                } else if (static_cast<uint8_t>(*raw) >= 0x80) {
+                    // has a unicode character: accept the whole run up to the next '"', '\\' or control char,
+                    // provided it is strictly valid UTF-8 (in which case the slow path would produce identical
+                    // output). Otherwise, leave it to the slow path to sort out.
+                    const char * const runEnd = kernels.findStringEnd(raw, end);
+                    if (!kernels.validUtf8(raw, runEnd))
                         return FastPath::NotFullyProcessed;
-                    } else if (ch < 0x20) {
-                        // is not legal JSON because < 0x20
+                    raw = runEnd;
+                    if (raw == end)
                         return FastPath::Error;
-                    } else if (ch >= 0x80) {
-                        // has a funky unicode character.. must take slow path
-                        return FastPath::NotFullyProcessed;
-                    }
                 }
-                // premature string end
+                const uint8_t ch = static_cast<uint8_t>(*raw);
+                if (ch == '"') {
+                    // fast-path accept case: simple string end at " char
+                    return FastPath::Processed;
+                } else if (ch == '\\') {
+                    // has escapes -- cannot process as simple string, must continue using slow path
+                    return FastPath::NotFullyProcessed;
+                }
+                // not legal JSON because < 0x20 (this includes NUL)
                 return FastPath::Error;
             };
-            switch (const char * const begin = buffer; FastPathParseSimpleString(buffer /*pass-by-ref*/)) {
+            switch (const char * const begin = buffer; FastPathParseSimpleString(buffer /*pass-by-ref*/, end)) {
             case FastPath::Processed:
-                // fast path taken -- the string had no embedded escapes or non-ascii characters, return
-                // early, set tokenVal, set consumed. Note: raw now points to trailing " char
+                // fast path taken -- the string had no embedded escapes or invalid UTF-8 sequences, return
+                // early, set tokenVal to point into the input, set consumed. Note: raw now points to trailing " char
                 assert(*buffer == '"');
-                tokenVal.assign(begin, buffer);
+                tokenVal = std::string_view(begin, buffer - begin);
                 ++buffer; // consume trailing "
                 return JTOK_STRING;
             case FastPath::NotFullyProcessed:
-                // we partially processed, put accepted chars into `tokenVal`
-                tokenVal.assign(begin, buffer);
+                // we partially processed, put accepted chars into `scratch`
+                scratch.assign(begin, buffer);
                 break; // will take slow path below
             case FastPath::Error:
                 // the fast path encountered premature string end or char < 0x20 -- abort early
@@ -393,16 +428,18 @@ jtokentype getJsonToken(std::string& tokenVal, const char*& buffer)
         // -----
         // Slow path -- scan 1 character at a time and process the chars thru JSONUTF8StringFilter
         // -----
-        if constexpr (reserveSize > 0)
-            tokenVal.reserve(tokenVal.capacity() + reserveSize);
-        JSONUTF8StringFilter writer(tokenVal); // note: this filter object must *not* clear tokenVal in its c'tor
+        if constexpr (!tryFastPath)
+            scratch.clear();
+        JSONUTF8StringFilter<String> writer(scratch); // note: this filter object must *not* clear scratch in its c'tor
 
         for (;;) {
-            if (static_cast<unsigned char>(*buffer) < 0x20)
+            if (buffer == end || static_cast<unsigned char>(*buffer) < 0x20)
                 return JTOK_ERR;
 
             else if (*buffer == '\\') {
-                switch (*++buffer) {             // skip backslash, read then skip esc'd char
+                if (++buffer == end)             // skip backslash
+                    return JTOK_ERR;
+                switch (*buffer) {               // read then skip esc'd char
                 case '"':  writer.push_back('"'); ++buffer; break;
                 case '\\': writer.push_back('\\'); ++buffer; break;
                 case '/':  writer.push_back('/'); ++buffer; break;
@@ -412,13 +449,13 @@ jtokentype getJsonToken(std::string& tokenVal, const char*& buffer)
                 case 'r':  writer.push_back('\r'); ++buffer; break;
                 case 't':  writer.push_back('\t'); ++buffer; break;
                 case 'u':
-                    if (auto optCodepoint = hatoui(++buffer)) { // skip u
+                    if (auto optCodepoint = hatoui(++buffer, end)) { // skip u
                         writer.push_back_u(*optCodepoint);
                         break;
                     }
                     [[fallthrough]];
                 default:
-                    return JTOK_ERR; // unexpected escape or '\0' after '\' char or codepoint failure
+                    return JTOK_ERR; // unexpected escape after '\' char or codepoint failure
                 } // switch
 
             }
@@ -436,10 +473,9 @@ jtokentype getJsonToken(std::string& tokenVal, const char*& buffer)
         if (!writer.finalize())
             return JTOK_ERR;
 
-        if constexpr (reserveSize > 0)
-            tokenVal.shrink_to_fit();
-        // -- At this point `tokenVal` contains the entire accepted string from
+        // -- At this point `scratch` contains the entire accepted string from
         // -- inside the enclosing quotes "", unescaped and UTF-8-processed.
+        tokenVal = scratch;
         return JTOK_STRING;
         }
 
@@ -453,10 +489,13 @@ jtokentype getJsonToken(std::string& tokenVal, const char*& buffer)
 namespace univalue_internal {
 std::optional<std::string> validateAndStripNumStr(const char* s)
 {
+    const char * const end = s + std::strlen(s);
     std::optional<std::string> ret;
     // string must contain a number and no junk at the end
-    if (std::string tokenVal, dummy; getJsonToken(tokenVal, s) == JTOK_NUMBER && getJsonToken(dummy, s) == JTOK_NONE) {
-        ret.emplace(std::move(tokenVal));
+    std::string_view tokenVal, dummy;
+    if (std::string scratch; getJsonToken(tokenVal, scratch, s, end) == JTOK_NUMBER
+                             && getJsonToken(dummy, scratch, s, end) == JTOK_NONE) {
+        ret.emplace(tokenVal);
     }
     return ret;
 }
@@ -483,7 +522,7 @@ bool ParsePrechecks(const std::string& str) noexcept
 }
 template <typename Integer>
 std::enable_if_t<std::is_integral_v<Integer>, bool>
-/*bool*/ GenericParseInt(const std::string& str, Integer *out)
+/*bool*/ GenericParseIntStrtol(const std::string& str, Integer *out)
 {
     static_assert (sizeof(Integer) > 1, "Disallow this function operating on bool, char, etc");
     constexpr bool is_signed = std::is_signed_v<Integer>;
@@ -510,12 +549,24 @@ std::enable_if_t<std::is_integral_v<Integer>, bool>
         n <= std::numeric_limits<Integer>::max();
 
 }
+
+template <typename Integer>
+std::enable_if_t<std::is_integral_v<Integer>, bool>
+/*bool*/ GenericParseInt(const std::string& str, Integer *out)
+{
+    if (const auto result = GenericParseIntFast(str, out))
+        return *result;
+    return GenericParseIntStrtol(str, out);
+}
 } // namespace
 bool ParseInt(const std::string& str, int *out) noexcept { return GenericParseInt(str, out); }
 bool ParseInt64(const std::string& str, int64_t *out) noexcept { return GenericParseInt(str, out); }
 bool ParseUInt(const std::string& str, unsigned *out) noexcept { return GenericParseInt(str, out); }
 bool ParseUInt64(const std::string& str, uint64_t *out) noexcept { return GenericParseInt(str, out); }
-bool ParseDouble(const std::string& str, double *out)
+namespace {
+// The previous implementation of ParseDouble(), which defines what it accepts, and the value returned. It is still
+// used for anything that is not a JSON number, and for numbers too large or too small for a double.
+bool ParseDoubleStream(const std::string& str, double *out)
 {
     if (!ParsePrechecks<true>(str))
         return false;
@@ -528,266 +579,1666 @@ bool ParseDouble(const std::string& str, double *out)
     if (out) *out = result;
     return text.eof() && !text.fail();
 }
+
+/// The decimal digits of a JSON number: its value is (negative ? -1 : 1) * mantissa * 10^exponent, provided that
+/// there were no more than 19 significant digits (otherwise `exact` is false, and the mantissa is truncated).
+struct DecimalNumber {
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    bool negative = false;
+    bool exact = true;
+};
+
+/// Returns the digits of `str`, or nothing if it is not a JSON number, i.e. -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+std::optional<DecimalNumber> ParseDecimal(std::string_view str) noexcept
+{
+    constexpr uint64_t maxMantissa = 999'999'999'999'999'999; // 19 digits
+    const auto IsDigit = [](char c) { return c >= '0' && c <= '9'; };
+    DecimalNumber num;
+    const char *p = str.data(), * const end = p + str.size();
+    const auto AddDigit = [&num](char c) {
+        if (num.mantissa <= maxMantissa / 10) {
+            num.mantissa = num.mantissa * 10 + uint64_t(c - '0');
+            return true;
+        }
+        num.exact = num.exact && c == '0'; // the mantissa is truncated, which only loses precision if the digit is not 0
+        return false;
+    };
+    if (p != end && *p == '-') {
+        num.negative = true;
+        ++p;
+    }
+    if (p == end || !IsDigit(*p) || (*p == '0' && p + 1 != end && IsDigit(p[1])))
+        return std::nullopt;
+    for (; p != end && IsDigit(*p); ++p)
+        if (!AddDigit(*p))
+            ++num.exponent; // a digit that did not fit the mantissa still multiplies it by 10
+    if (p != end && *p == '.') {
+        if (++p == end || !IsDigit(*p))
+            return std::nullopt;
+        for (; p != end && IsDigit(*p); ++p)
+            if (AddDigit(*p))
+                --num.exponent;
+    }
+    if (p != end && (*p == 'e' || *p == 'E')) {
+        bool negativeExp = false;
+        if (++p != end && (*p == '+' || *p == '-'))
+            negativeExp = *p++ == '-';
+        if (p == end || !IsDigit(*p))
+            return std::nullopt;
+        int exp = 0;
+        for (; p != end && IsDigit(*p); ++p)
+            if (exp < 100'000) // far beyond the range of a double, so there is no need to keep counting
+                exp = exp * 10 + (*p - '0');
+        num.exponent += negativeExp ? -exp : exp;
+    }
+    if (p != end)
+        return std::nullopt;
+    return num;
+}
+
+/// Clinger's fast path: if the mantissa and the power of 10 are both exactly representable as doubles, the number is
+/// their product or quotient, which IEEE 754 arithmetic rounds correctly. This covers most numbers seen in practice,
+/// such as amounts with 8 decimals, and needs no big-number arithmetic. Returns nothing for any other number.
+std::optional<double> ParseDoubleFast(const DecimalNumber &num) noexcept
+{
+#if FLT_EVAL_METHOD == 0 // (not so if intermediate results have extra precision, as with the x87 FPU)
+    static constexpr double powersOf10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+    constexpr uint64_t maxExactInt = uint64_t(1) << std::numeric_limits<double>::digits;
+    if (num.exact && num.mantissa <= maxExactInt && num.exponent >= -22 && num.exponent <= 22) {
+        double d = double(num.mantissa);
+        d = num.exponent < 0 ? d / powersOf10[-num.exponent] : d * powersOf10[num.exponent];
+        return num.negative ? -d : d;
+    }
+    if (num.mantissa == 0)
+        return num.negative ? -0.0 : 0.0;
+#else
+    (void)num;
+#endif
+    return std::nullopt;
+}
+} // namespace
+
+bool ParseDouble(const std::string& str, double *out)
+{
+    // JSON numbers (i.e. all numbers read, and all of those assigned) are parsed directly, without a stream, locale
+    // or allocation.
+    if (const auto num = ParseDecimal(str)) {
+        if (const auto d = ParseDoubleFast(*num)) {
+            if (out) *out = *d;
+            return true;
+        }
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        double result;
+        const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), result);
+        if (ec == std::errc{} && ptr == str.data() + str.size()) {
+            if (out) *out = result;
+            return true;
+        }
+        // Otherwise, the number overflows, or underflows to 0 (which is accepted below, unlike with from_chars())
+#endif
+    }
+    return ParseDoubleStream(str, out);
+}
+
+FixedResult ScaleFixed(bool negative, uint64_t magnitude, int exponent, unsigned decimals, int64_t *out) noexcept
+{
+    if (magnitude) {
+        // Each of these loops ends after at most 20 iterations, when the magnitude runs out of digits
+        for (int scale = exponent + int(decimals); scale < 0; ++scale) {
+            if (magnitude % 10)
+                return FixedResult::TooPrecise;
+            magnitude /= 10;
+        }
+        for (int scale = exponent + int(decimals); scale > 0; --scale) {
+            if (magnitude > std::numeric_limits<uint64_t>::max() / 10)
+                return FixedResult::OutOfRange;
+            magnitude *= 10;
+        }
+    }
+    // (the magnitude of the minimum is 1 more than the maximum)
+    if (magnitude > uint64_t(std::numeric_limits<int64_t>::max()) + negative)
+        return FixedResult::OutOfRange;
+    if (out) *out = negative && magnitude ? -int64_t(magnitude - 1) - 1 : int64_t(magnitude);
+    return FixedResult::Ok;
+}
+
+FixedResult ParseFixed(std::string_view str, unsigned decimals, int64_t *out) noexcept
+{
+    // As ParseDecimal() above, but exact: past 19 significant digits, trailing zeros (e.g. of a long "1.000...") are
+    // counted rather than added to the mantissa, so that only the digits up to the last non-zero one need to fit.
+    const auto IsDigit = [](char c) { return c >= '0' && c <= '9'; };
+    const char *p = str.data(), * const end = p + str.size();
+    uint64_t magnitude = 0;
+    int digits = 0; // significant digits in the magnitude: up to 19 of them always fit, trailing zeros and all
+    int zeros = 0; // zeros after the last non-zero digit, not (yet) in the magnitude
+    int fractionDigits = 0;
+    bool tooManyDigits = false;
+    const auto AddDigit = [&](char c) {
+        if (digits < 19) {
+            magnitude = magnitude * 10 + uint64_t(c - '0');
+            digits += magnitude != 0; // (leading zeros do not count)
+            return;
+        }
+        if (c == '0') {
+            ++zeros;
+            return;
+        }
+        for (; zeros >= 0; --zeros) { // the zeros, then the digit itself
+            tooManyDigits = tooManyDigits || magnitude > std::numeric_limits<uint64_t>::max() / 10;
+            magnitude *= 10;
+        }
+        zeros = 0;
+        tooManyDigits = tooManyDigits || magnitude > std::numeric_limits<uint64_t>::max() - uint64_t(c - '0');
+        magnitude += uint64_t(c - '0');
+    };
+    const bool negative = p != end && *p == '-';
+    p += negative;
+    if (p == end || !IsDigit(*p) || (*p == '0' && p + 1 != end && IsDigit(p[1])))
+        return FixedResult::NotANumber;
+    for (; p != end && IsDigit(*p); ++p)
+        AddDigit(*p);
+    if (p != end && *p == '.') {
+        if (++p == end || !IsDigit(*p))
+            return FixedResult::NotANumber;
+        for (; p != end && IsDigit(*p); ++p, ++fractionDigits)
+            AddDigit(*p);
+    }
+    int exponent = 0;
+    if (p != end && (*p == 'e' || *p == 'E')) {
+        bool negativeExp = false;
+        if (++p != end && (*p == '+' || *p == '-'))
+            negativeExp = *p++ == '-';
+        if (p == end || !IsDigit(*p))
+            return FixedResult::NotANumber;
+        for (; p != end && IsDigit(*p); ++p)
+            if (exponent < 100'000) // far beyond the range of an int64_t, so there is no need to keep counting
+                exponent = exponent * 10 + (*p - '0');
+        if (negativeExp)
+            exponent = -exponent;
+    }
+    if (p != end)
+        return FixedResult::NotANumber;
+    // The number is now (negative ? -1 : 1) * magnitude * 10^exponent, where the last digit of the magnitude is its
+    // last non-zero digit
+    exponent += zeros - fractionDigits;
+    if (tooManyDigits) // i.e. 20 or more significant digits, which is either too precise or out of range
+        return exponent + int(decimals) < 0 ? FixedResult::TooPrecise : FixedResult::OutOfRange;
+    return ScaleFixed(negative, magnitude, exponent, decimals, out);
+}
 } // namespace univalue_internal
 
-const char* UniValue::read(const char* buffer, const char** errpos)
-{
-    // wrapped nested function (we catch its return and possibly set errpos)
-    const char * const ret = [this, &buffer]() -> const char * {
-        setNull(); // clear this
-        enum expect_bits {
-            EXP_OBJ_NAME = (1U << 0),
-            EXP_COLON = (1U << 1),
-            EXP_ARR_VALUE = (1U << 2),
-            EXP_VALUE = (1U << 3),
-            EXP_NOT_VALUE = (1U << 4),
-        };
-#define expect(bit) (expectMask & (EXP_##bit))
-#define setExpect(bit) (expectMask |= EXP_##bit)
-#define clearExpect(bit) (expectMask &= ~EXP_##bit)
-
-        uint32_t expectMask = 0;
-        std::vector<UniValue*> stack;
-
-        std::string tokenVal;
-        jtokentype tok = JTOK_NONE;
-        jtokentype last_tok = JTOK_NONE;
-        do {
-            last_tok = tok;
-
-            tok = getJsonToken(tokenVal, buffer);
-            if (tok == JTOK_NONE || tok == JTOK_ERR)
-                return nullptr;
-
-            bool isValueOpen = jsonTokenIsValue(tok) ||
-                tok == JTOK_OBJ_OPEN || tok == JTOK_ARR_OPEN;
-
-            if (expect(VALUE)) {
-                if (!isValueOpen)
-                    return nullptr;
-                clearExpect(VALUE);
-
-            } else if (expect(ARR_VALUE)) {
-                bool isArrValue = isValueOpen || (tok == JTOK_ARR_CLOSE);
-                if (!isArrValue)
-                    return nullptr;
-
-                clearExpect(ARR_VALUE);
-
-            } else if (expect(OBJ_NAME)) {
-                bool isObjName = (tok == JTOK_OBJ_CLOSE || tok == JTOK_STRING);
-                if (!isObjName)
-                    return nullptr;
-
-            } else if (expect(COLON)) {
-                if (tok != JTOK_COLON)
-                    return nullptr;
-                clearExpect(COLON);
-
-            } else if (!expect(COLON) && (tok == JTOK_COLON)) {
-                return nullptr;
-            }
+struct UniValue::Parser {
+    // These construct the value in-place from a view of the token. If `uv` already holds a value of the same type,
+    // its storage is reused instead: strings are assigned to, and objects and arrays are returned as they are (their
+    // existing elements are overwritten and trimmed by the read engine, see ReadMember() and ReadElement()).
+    static void setStr(UniValue &uv, std::string_view s) { assign<std::string>(uv, s); }
+    static void setNumStr(UniValue &uv, std::string_view s) { assign<NumStr>(uv, s); }
+    static Object &setObject(UniValue &uv, std::pmr::memory_resource *mr) { return reuse<Object>(uv, mr); }
+    static Array &setArray(UniValue &uv, std::pmr::memory_resource *mr) { return reuse<Array>(uv, mr); }
 
-            if (expect(NOT_VALUE)) {
-                if (isValueOpen)
-                    return nullptr;
-                clearExpect(NOT_VALUE);
-            }
+    // Access to an object or array being read, which is known to be one
+    static Object &object(UniValue &uv) { return uv.var.get<Object>(); }
+    static Array &array(UniValue &uv) { return uv.var.get<Array>(); }
 
-            switch (tok) {
+    /// Implements UniValue::read(), UniValue::readInPlace() and UniValue::Document::read(). New objects and arrays are
+    /// allocated from `mr`, or from the heap if `mr` is nullptr. Unless `inPlace`, `uv` is cleared first.
+    static const char *read(UniValue &uv, const char *buffer, size_t len, const char **errpos, ReadEngine engine,
+                            std::pmr::memory_resource *mr, bool inPlace = false);
 
-            case JTOK_OBJ_OPEN:
-            case JTOK_ARR_OPEN: {
-                VType utyp = (tok == JTOK_OBJ_OPEN ? VOBJ : VARR);
-                if (!stack.size()) {
-                    if (utyp == VOBJ)
-                        setObject();
-                    else
-                        setArray();
-                    stack.push_back(this);
-                } else {
-                    UniValue *top = stack.back();
-                    if (top->type() == VOBJ) {
-                        auto& value = top->var.get<Object>().rbegin()->second;
-                        if (utyp == VOBJ)
-                            value.setObject();
-                        else
-                            value.setArray();
-                        stack.push_back(&value);
-                    } else {
-                        Array & arr = top->var.get<Array>();
-                        arr.emplace_back(utyp);
-                        stack.push_back(&*arr.rbegin());
-                    }
-                }
+private:
+    template <typename T>
+    static void assign(UniValue &uv, std::string_view s) {
+        if (uv.var.holds_alternative<T>())
+            uv.var.get<T>().assign(s.data(), s.size());
+        else
+            uv.var.emplace<T>(s.data(), s.size());
+    }
+    template <typename T>
+    static T &reuse(UniValue &uv, std::pmr::memory_resource *mr) {
+        return uv.var.holds_alternative<T>() ? uv.var.get<T>() : uv.var.emplace<T>(mr);
+    }
+};
 
-                if (stack.size() > MAX_JSON_DEPTH)
-                    return nullptr;
+namespace {
 
-                if (utyp == VOBJ)
-                    setExpect(OBJ_NAME);
-                else
-                    setExpect(ARR_VALUE);
-                break;
-                }
+#if defined(UNIVALUE_READ_ENGINE_STRUCTURAL_INDEX)
+inline constexpr UniValue::ReadEngine DEFAULT_READ_ENGINE = UniValue::ReadEngine::StructuralIndex;
+#else
+inline constexpr UniValue::ReadEngine DEFAULT_READ_ENGINE = UniValue::ReadEngine::Tokenizer;
+#endif
 
-            case JTOK_OBJ_CLOSE:
-            case JTOK_ARR_CLOSE: {
-                if (!stack.size() || (last_tok == JTOK_COMMA))
-                    return nullptr;
+/// Returns the value of member number `n` of the object being read, after setting its key. An existing member is
+/// overwritten (as UniValue::readInPlace() does), so that its key and value keep their storage.
+inline UniValue &ReadMember(UniValue::Object &obj, size_t n, std::string_view key)
+{
+    if (n < obj.size()) {
+        auto &entry = obj.begin()[n];
+        entry.first.assign(key.data(), key.size());
+        return entry.second;
+    }
+    obj.emplace_back(std::piecewise_construct, std::forward_as_tuple(key.data(), key.size()), std::forward_as_tuple());
+    return obj.rbegin()->second;
+}
 
-                VType utyp = (tok == JTOK_OBJ_CLOSE ? VOBJ : VARR);
-                UniValue *top = stack.back();
-                if (utyp != top->getType())
-                    return nullptr;
+/// Returns element number `n` of the array being read, which is either an existing element to overwrite or a new one.
+inline UniValue &ReadElement(UniValue::Array &arr, size_t n)
+{
+    if (n < arr.size())
+        return arr.begin()[n];
+    arr.emplace_back();
+    return *arr.rbegin();
+}
 
-                stack.pop_back();
-                clearExpect(OBJ_NAME);
-                setExpect(NOT_VALUE);
-                break;
-                }
+/// Reserves room in the object or array `c`, which is about to be read, for as many members or elements as its previous
+/// sibling (if any, and if of the same type) has. Arrays of objects that share the same keys -- records -- are the norm,
+/// so this predicts the size well, saving the reallocations of growing `c` one member at a time. Large siblings are not
+/// followed: a reservation is never given back, and one large value followed by many small ones is common too.
+template <typename Container>
+inline void ReserveLikeSibling(Container &c, const UniValue *sibling)
+{
+    constexpr size_t maxReserve = 64; // records have fewer members than this, and growing past it costs little
+    if (sibling && (std::is_same_v<Container, UniValue::Object> ? sibling->isObject() : sibling->isArray())
+        && sibling->size() <= maxReserve)
+        c.reserve(sibling->size());
+}
+
+/// Removes any elements left over from a previous value, once an object or array of `n` elements has been read.
+template <typename Container>
+inline bool ReadEnd(Container &c, size_t n)
+{
+    if (n < c.size())
+        c.erase(c.begin() + n, c.end());
+    return true;
+}
+
+/**
+ * The sink of TokenReader that builds the tree of a UniValue. Each value is read into the UniValue that `Value` points
+ * to, which is overwritten (see UniValue::Parser). Never stops the reader.
+ */
+struct DomSink {
+    using Value = UniValue *;
+    using Object = UniValue::Object *;
+    using Array = UniValue::Array *;
+
+    std::pmr::memory_resource * const mr; // objects and arrays are allocated from this (nullptr: the heap)
+    const UniValue *sibling = nullptr;    // the previous sibling of the value about to be read, if any
+    // Set when the first value read is an item of UniValue::readParallel() that begins a run: its previous sibling is
+    // then being read by another thread, and must not be looked at.
+    bool firstOfRun = false;
+
+    bool startObject(Value v, Object &obj) {
+        obj = &UniValue::Parser::setObject(*v, mr);
+        ReserveLikeSibling(*obj, sibling);
+        return true;
+    }
+    bool key(Object obj, size_t n, std::string_view key, Value &v) {
+        v = &ReadMember(*obj, n, key);
+        sibling = n && !firstOfRun ? &obj->begin()[n - 1].second : nullptr;
+        firstOfRun = false;
+        return true;
+    }
+    bool endObject(Object obj, size_t n) { return ReadEnd(*obj, n); }
+    bool startArray(Value v, Array &arr) {
+        arr = &UniValue::Parser::setArray(*v, mr);
+        ReserveLikeSibling(*arr, sibling);
+        return true;
+    }
+    bool element(Array arr, size_t n, Value &v) {
+        v = &ReadElement(*arr, n);
+        sibling = n && !firstOfRun ? &arr->begin()[n - 1] : nullptr;
+        firstOfRun = false;
+        return true;
+    }
+    bool endArray(Array arr, size_t n) { return ReadEnd(*arr, n); }
+    bool skip(Value) const { return false; }
+    bool string(Value v, std::string_view s) { UniValue::Parser::setStr(*v, s); return true; }
+    bool number(Value v, std::string_view s) { UniValue::Parser::setNumStr(*v, s); return true; }
+    bool null(Value v) { v->setNull(); return true; }
+    bool boolean(Value v, bool b) { *v = b; return true; }
+};
 
-            case JTOK_COLON: {
-                if (!stack.size())
-                    return nullptr;
+/// The sink of TokenReader that forwards the parse events to a UniValue::SaxHandler, which may stop the reader.
+struct SaxSink {
+    struct Value {};
+    using Object = Value;
+    using Array = Value;
+
+    UniValue::SaxHandler &handler;
+
+    bool startObject(Value, Object &) { return handler.onStartObject(); }
+    bool key(Object, size_t, std::string_view key, Value &) { return handler.onKey(key); }
+    bool endObject(Object, size_t n) { return handler.onEndObject(n); }
+    bool startArray(Value, Array &) { return handler.onStartArray(); }
+    bool element(Array, size_t, Value &) { return true; }
+    bool endArray(Array, size_t n) { return handler.onEndArray(n); }
+    bool skip(Value) const { return false; }
+    bool string(Value, std::string_view s) { return handler.onString(s); }
+    bool number(Value, std::string_view s) { return handler.onNumber(s); }
+    bool null(Value) { return handler.onNull(); }
+    bool boolean(Value, bool b) { return handler.onBool(b); }
+};
 
-                UniValue *top = stack.back();
-                if (top->getType() != VOBJ)
-                    return nullptr;
+/// The sink of TokenReader that implements UniValue::validate(): it ignores everything.
+struct ValidateSink {
+    struct Value {};
+    using Object = Value;
+    using Array = Value;
+
+    bool startObject(Value, Object &) { return true; }
+    bool key(Object, size_t, std::string_view, Value &) { return true; }
+    bool endObject(Object, size_t) { return true; }
+    bool startArray(Value, Array &) { return true; }
+    bool element(Array, size_t, Value &) { return true; }
+    bool endArray(Array, size_t) { return true; }
+    bool skip(Value) const { return false; }
+    bool string(Value, std::string_view) { return true; }
+    bool number(Value, std::string_view) { return true; }
+    bool null(Value) { return true; }
+    bool boolean(Value, bool) { return true; }
+};
 
-                setExpect(VALUE);
-                break;
-                }
+/**
+ * The Tokenizer read engine: a recursive-descent parser over the tokens returned by getJsonToken().
+ *
+ * The position within the grammar is encoded in the control flow (and the nesting depth in the call stack), so each
+ * token is only ever compared against the few tokens that may legally appear where it was read. What is done with the
+ * values read is up to the `Sink` (DomSink or SaxSink): with DomSink, values are built directly in their final place
+ * in the tree. Each Sink method returns false to stop the reader, except for skip(), which returns true for the values
+ * the sink has no use for: those are only validated, by a TokenReader<ValidateSink, NullString>. Strings with escapes
+ * are unescaped into a `Scratch`, which is a NullString for sinks that have no use for the values of strings.
+ *
+ * On failure, `buffer` is left just past the first token that cannot continue a valid document (or at the offending
+ * character if the token itself is malformed), which is what the caller reports as the error position.
+ */
+template <typename Sink, typename Scratch = std::string>
+class TokenReader
+{
+    const char *&buffer;
+    const char * const end;
+    Sink sink;
+    std::string_view tokenVal;
+    Scratch scratch; // work area for unescaping strings, reused for every string token
 
-            case JTOK_COMMA: {
-                if (!stack.size() || (last_tok == JTOK_COMMA) || (last_tok == JTOK_ARR_OPEN))
-                    return nullptr;
+    jtokentype next() { return getJsonToken(tokenVal, scratch, buffer, end); }
 
-                UniValue *top = stack.back();
-                if (top->getType() == VOBJ)
-                    setExpect(OBJ_NAME);
-                else
-                    setExpect(ARR_VALUE);
-                break;
-                }
+    using Value = typename Sink::Value;
 
+    /// Reads the value that begins with token `tok` (which has already been consumed) into `out`.
+    bool readValue(Value out, jtokentype tok, size_t depth)
+    {
+        switch (tok) {
+        case JTOK_OBJ_OPEN: {
+            if (++depth > MAX_JSON_DEPTH)
+                return false;
+            typename Sink::Object obj;
+            if (!sink.startObject(out, obj))
+                return false;
+            tok = next();
+            if (tok == JTOK_OBJ_CLOSE)
+                return sink.endObject(obj, 0);
+            for (size_t n = 0;; ++n) {
+                if (tok != JTOK_STRING)
+                    return false;
+                Value val;
+                if (!sink.key(obj, n, tokenVal, val) || next() != JTOK_COLON || !readNextValue(val, depth))
+                    return false;
+                tok = next();
+                if (tok == JTOK_OBJ_CLOSE)
+                    return sink.endObject(obj, n + 1);
+                if (tok != JTOK_COMMA)
+                    return false;
+                tok = next();
+            }
+        }
+        case JTOK_ARR_OPEN: {
+            if (++depth > MAX_JSON_DEPTH)
+                return false;
+            typename Sink::Array arr;
+            if (!sink.startArray(out, arr))
+                return false;
+            // The first token of each element is only read once its Value is known (see readNextValue()), so peek
+            if (buffer != end && json_isspace(*buffer))
+                buffer = univalue_internal::simd().skipWhitespace(buffer, end);
+            if (buffer != end && *buffer == ']') {
+                ++buffer;
+                return sink.endArray(arr, 0);
+            }
+            for (size_t n = 0;; ++n) {
+                Value val;
+                if (!sink.element(arr, n, val) || !readNextValue(val, depth))
+                    return false;
+                tok = next();
+                if (tok == JTOK_ARR_CLOSE)
+                    return sink.endArray(arr, n + 1);
+                if (tok != JTOK_COMMA)
+                    return false;
+            }
+        }
+        case JTOK_STRING:
+            return sink.string(out, tokenVal);
+        case JTOK_NUMBER:
+            return sink.number(out, tokenVal);
+        case JTOK_KW_NULL:
+            return sink.null(out);
+        case JTOK_KW_TRUE:
+            return sink.boolean(out, true);
+        case JTOK_KW_FALSE:
+            return sink.boolean(out, false);
+        default:
+            // error, end of input, or a structural character where a value was expected
+            return false;
+        }
+    }
+
+    /// Reads the value that begins with the next token into `out`, unless the sink skips it, in which case it is only
+    /// validated: its strings are not unescaped, and no memory is allocated.
+    bool readNextValue(Value out, size_t depth)
+    {
+        if (sink.skip(out))
+            return TokenReader<ValidateSink, NullString>(buffer, end, ValidateSink{}).readNextValue({}, depth);
+        return readValue(out, next(), depth);
+    }
+
+    template <typename, typename> friend class TokenReader;
+
+public:
+    TokenReader(const char *&buffer_, const char *end_, Sink sink_) noexcept
+        : buffer(buffer_), end(end_), sink(sink_) {}
+
+    /// Returns true on success, in which case the entire document has been read into `out`.
+    bool read(Value out) { return readValue(out, next(), 0) && next() == JTOK_NONE; }
+
+    // These read the input as just the member `n` of `obj` (its key, the colon and the value), or just the element `n`
+    // of `arr`, where `obj` or `arr` is at nesting depth `depth`. Used by UniValue::readParallel().
+    bool readMember(typename Sink::Object obj, size_t n, size_t depth)
+    {
+        Value val;
+        return next() == JTOK_STRING && sink.key(obj, n, tokenVal, val) && next() == JTOK_COLON
+               && readValue(val, next(), depth) && next() == JTOK_NONE;
+    }
+    bool readElement(typename Sink::Array arr, size_t n, size_t depth)
+    {
+        Value val;
+        return sink.element(arr, n, val) && readValue(val, next(), depth) && next() == JTOK_NONE;
+    }
+};
+
+/**
+ * Stage 2 of the StructuralIndex read engine: builds the tree by walking the structural index of the input built
+ * by univalue_internal::BuildStructuralIndex() (stage 1).
+ *
+ * Only the positions of the tokens come from the index; the tokens themselves are still parsed by getJsonToken(),
+ * which guarantees the exact same results as the Tokenizer engine. This walker only reports success or failure. On
+ * failure the caller reruns the Tokenizer engine, which fails in the same way and determines the error position.
+ */
+class IndexedReader
+{
+    const char * const begin, * const end;
+    std::pmr::memory_resource * const mr; // objects and arrays are allocated from this (nullptr: the heap)
+    const uint32_t *pos, * const posEnd;
+    std::string_view tokenVal;
+    std::string scratch;
+
+    /// Returns true if there is nothing but whitespace between `p` and the next indexed position (or end of input).
+    /// This catches junk in between tokens, e.g. `truex` or `"a"b`, which is not indexed.
+    bool atNext(const char *p) const noexcept
+    {
+        const char * const next = pos != posEnd ? begin + *pos : end;
+        while (p < next && json_isspace(*p))
+            ++p;
+        return p == next;
+    }
+
+    /// Reads the value at the next position into `out`, whose previous sibling (if any) is `sibling`
+    bool readValue(UniValue &out, const UniValue *sibling, size_t depth)
+    {
+        if (pos == posEnd)
+            return false;
+        const char *p = begin + *pos++;
+        switch (*p) {
+        case '{': {
+            if (++depth > MAX_JSON_DEPTH)
+                return false;
+            UniValue::Object &obj = UniValue::Parser::setObject(out, mr);
+            ReserveLikeSibling(obj, sibling);
+            if (pos != posEnd && begin[*pos] == '}') {
+                ++pos;
+                return ReadEnd(obj, 0);
+            }
+            for (size_t n = 0;; ++n) {
+                if (pos == posEnd || begin[*pos] != '"')
+                    return false;
+                p = begin + *pos++;
+                if (getJsonToken(tokenVal, scratch, p, end) != JTOK_STRING || !atNext(p))
+                    return false;
+                if (pos == posEnd || begin[*pos++] != ':')
+                    return false;
+                UniValue &val = ReadMember(obj, n, tokenVal); // (may reallocate, so before taking its sibling)
+                if (!readValue(val, n ? &obj.begin()[n - 1].second : nullptr, depth) || pos == posEnd)
+                    return false;
+                const char c = begin[*pos++];
+                if (c == '}')
+                    return ReadEnd(obj, n + 1);
+                if (c != ',')
+                    return false;
+            }
+        }
+        case '[': {
+            if (++depth > MAX_JSON_DEPTH)
+                return false;
+            UniValue::Array &arr = UniValue::Parser::setArray(out, mr);
+            ReserveLikeSibling(arr, sibling);
+            if (pos != posEnd && begin[*pos] == ']') {
+                ++pos;
+                return ReadEnd(arr, 0);
+            }
+            for (size_t n = 0;; ++n) {
+                UniValue &val = ReadElement(arr, n); // (may reallocate, so before taking its sibling)
+                if (!readValue(val, n ? &arr.begin()[n - 1] : nullptr, depth) || pos == posEnd)
+                    return false;
+                const char c = begin[*pos++];
+                if (c == ']')
+                    return ReadEnd(arr, n + 1);
+                if (c != ',')
+                    return false;
+            }
+        }
+        default:
+            switch (getJsonToken(tokenVal, scratch, p, end)) {
+            case JTOK_STRING:
+                UniValue::Parser::setStr(out, tokenVal);
+                break;
+            case JTOK_NUMBER:
+                UniValue::Parser::setNumStr(out, tokenVal);
+                break;
             case JTOK_KW_NULL:
+                out.setNull();
+                break;
             case JTOK_KW_TRUE:
-            case JTOK_KW_FALSE: {
-                UniValue tmpVal;
-                switch (tok) {
-                case JTOK_KW_NULL:
-                    // do nothing more
-                    break;
-                case JTOK_KW_TRUE:
-                    tmpVal = true;
-                    break;
-                case JTOK_KW_FALSE:
-                    tmpVal = false;
-                    break;
-                default: /* impossible */ break;
-                }
+                out = true;
+                break;
+            case JTOK_KW_FALSE:
+                out = false;
+                break;
+            default:
+                // error, or a structural character where a value was expected
+                return false;
+            }
+            return atNext(p);
+        }
+    }
 
-                if (!stack.size()) {
-                    *this = std::move(tmpVal);
-                    break;
-                }
+public:
+    IndexedReader(const char *begin_, const char *end_, const univalue_internal::StructuralIndex &index,
+                  std::pmr::memory_resource *mr_) noexcept
+        : begin(begin_), end(end_), mr(mr_), pos(index.positions.get()), posEnd(pos + index.size) {}
 
-                UniValue *top = stack.back();
-                if (top->type() == VOBJ) {
-                    top->var.get<Object>().rbegin()->second = std::move(tmpVal);
-                } else {
-                    top->var.get<Array>().emplace_back(std::move(tmpVal));
-                }
+    /// Returns true on success, in which case `out` holds the entire document.
+    bool read(UniValue &out) { return readValue(out, nullptr, 0) && pos == posEnd; }
+};
 
-                setExpect(NOT_VALUE);
-                break;
-                }
+/// Returns true on success. Note that on failure `uv` may be partially constructed.
+bool ReadStructuralIndex(UniValue &uv, const char *buffer, size_t len, std::pmr::memory_resource *mr)
+{
+    // The index buffer is kept around for reuse by subsequent reads on this thread, unless it got very large.
+    constexpr size_t maxRetainedCapacity = 4u << 20; // 16 MiB worth of positions
+    thread_local univalue_internal::StructuralIndex index;
+    struct Cleanup {
+        univalue_internal::StructuralIndex &index;
+        ~Cleanup() {
+            if (index.capacity > maxRetainedCapacity)
+                index = univalue_internal::StructuralIndex{};
+        }
+    } cleanup{index};
 
-            case JTOK_NUMBER: {
-                UniValue tmpVal(VNUM, std::move(tokenVal));
-                if (!stack.size()) {
-                    *this = std::move(tmpVal);
-                    break;
-                }
+    return univalue_internal::BuildStructuralIndex(buffer, len, index)
+           && IndexedReader(buffer, buffer + len, index, mr).read(uv);
+}
 
-                UniValue *top = stack.back();
-                if (top->type() == VOBJ) {
-                    top->var.get<Object>().rbegin()->second = std::move(tmpVal);
-                } else {
-                    top->var.get<Array>().emplace_back(std::move(tmpVal));
-                }
+/// Adapts a read() of a pointer and length to a read() of a std::string_view.
+template <typename ReadFunc>
+bool ReadStringView(std::string_view raw, std::string_view::size_type *errpos, ReadFunc &&readFunc)
+{
+    const char* errptr;
+    const bool ok = readFunc(raw.data(), raw.size(), &errptr) != nullptr;
+    if (errpos) *errpos = ok ? std::string_view::npos : static_cast<std::string_view::size_type>(errptr - raw.data());
+    return ok;
+}
 
-                setExpect(NOT_VALUE);
-                break;
-                }
+} // namespace
 
-            case JTOK_STRING: {
-                if (expect(OBJ_NAME)) {
-                    UniValue *top = stack.back();
-                    top->var.get<Object>().emplace_back(std::piecewise_construct,
-                                                        std::forward_as_tuple(std::move(tokenVal)),
-                                                        std::forward_as_tuple());
-                    clearExpect(OBJ_NAME);
-                    setExpect(COLON);
-                } else {
-                    UniValue tmpVal(VSTR, std::move(tokenVal));
-                    if (!stack.size()) {
-                        *this = std::move(tmpVal);
+/* static */
+const char* UniValue::Parser::read(UniValue &uv, const char *buffer, size_t len, const char **errpos,
+                                   ReadEngine engine, std::pmr::memory_resource *mr, bool inPlace)
+{
+    const char * const end = buffer + len;
+    if (engine == ReadEngine::Default)
+        engine = DEFAULT_READ_ENGINE;
+    if (!inPlace)
+        uv.setNull(); // clear this
+    if (engine == ReadEngine::StructuralIndex) {
+        if (ReadStructuralIndex(uv, buffer, len, mr)) {
+            if (errpos) *errpos = nullptr;
+            return end;
+        }
+        // Fall back to the Tokenizer engine below, to determine the error position
+    }
+
+    const char * const ret = TokenReader<DomSink>(buffer, end, DomSink{mr}).read(&uv) ? buffer : nullptr;
+
+    // if caller specfied errpos pointer, set it
+    if (errpos) {
+        *errpos = ret == nullptr ? buffer : nullptr;
+    }
+
+    return ret;
+}
+
+namespace {
+/// The top-level members or elements of a document, as found by FindTopLevelItems().
+struct TopLevelItems {
+    char open{}; ///< '{' or '['
+    /// The offsets of the opening bracket, of each top-level comma, and of the closing bracket. Item `i` of the root
+    /// lies in between `separators[i]` and `separators[i + 1]`.
+    std::vector<uint32_t> separators;
+};
+
+/// Finds the top-level members or elements of the object or array in the `len` bytes at `buffer`, by tracking the
+/// nesting depth block by block (rather than building the full structural index). Returns false if they cannot be
+/// determined this way, which is the case for some invalid input (all other errors are left for the reading of the
+/// individual items to detect).
+bool FindTopLevelItems(const char *buffer, size_t len, TopLevelItems &items)
+{
+    const char * const first = std::find_if_not(buffer, buffer + len, json_isspace);
+    if (first == buffer + len || (*first != '{' && *first != '['))
+        return false;
+    items.open = *first;
+    if (!univalue_internal::FindTopLevelSeparators(buffer, len, items.separators))
+        return false;
+    // The root must be followed by nothing but whitespace
+    return std::all_of(buffer + items.separators.back() + 1, buffer + len, json_isspace);
+}
+} // namespace
+
+const char* UniValue::readParallel(const char* buffer, size_t len, const char** errpos, unsigned threads)
+{
+    // By default, each thread gets at least this much of the input, so that the threads are worth their overhead
+    constexpr size_t minBytesPerThread = 16 * 1024;
+
+    if (!threads)
+        threads = std::min<size_t>(std::thread::hardware_concurrency(), len / minBytesPerThread);
+    TopLevelItems items;
+    if (threads <= 1 || !FindTopLevelItems(buffer, len, items) || items.separators.size() < 3)
+        return read(buffer, len, errpos); // nothing to gain (or an error to report)
+
+    // Make room for all of the items first, so that the threads may each read theirs in place, independently
+    const size_t nItems = items.separators.size() - 1;
+    setNull();
+    Object *obj = nullptr;
+    Array *arr = nullptr;
+    if (items.open == '{') {
+        obj = &Parser::setObject(*this, nullptr);
+        obj->reserve(nItems);
+        for (size_t i = 0; i < nItems; ++i)
+            obj->emplace_back(std::piecewise_construct, std::forward_as_tuple(), std::forward_as_tuple());
+    } else {
+        arr = &Parser::setArray(*this, nullptr);
+        arr->reserve(nItems);
+        for (size_t i = 0; i < nItems; ++i)
+            arr->emplace_back();
+    }
+
+    // Reads items [first, last), returning false on error. Item `first` does not take item `first - 1`, which belongs to
+    // another run, as its sibling.
+    const auto readItems = [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            const char *p = buffer + items.separators[i] + 1;
+            TokenReader<DomSink> reader(p, buffer + items.separators[i + 1], DomSink{nullptr, nullptr, i == first});
+            if (!(obj ? reader.readMember(obj, i, 1) : reader.readElement(arr, i, 1)))
+                return false;
+        }
+        return true;
+    };
+
+    // Split the items into `threads` runs of about the same number of bytes, and read all but the last run on threads
+    // of their own.
+    std::vector<std::future<bool>> results;
+    results.reserve(threads - 1);
+    size_t first = 0;
+    for (unsigned t = 1; t < threads && first < nItems; ++t) {
+        const uint32_t cut = items.separators[0] + (uint64_t(items.separators.back() - items.separators[0]) * t) / threads;
+        const size_t last = std::max(first + 1, size_t(std::upper_bound(items.separators.begin(), items.separators.end(), cut)
+                                                       - items.separators.begin()) - 1);
+        if (last >= nItems)
+            break;
+        results.push_back(std::async(std::launch::async, readItems, first, last));
+        first = last;
+    }
+    bool ok = readItems(first, nItems);
+    for (auto &result : results)
+        ok = result.get() && ok;
+
+    if (!ok)
+        return read(buffer, len, errpos); // read it again, in order to determine the error position
+    if (errpos) *errpos = nullptr;
+    return buffer + len;
+}
+
+bool UniValue::readParallel(std::string_view raw, std::string_view::size_type *errpos, unsigned threads)
+{
+    return ReadStringView(raw, errpos, [&](const char *data, size_t len, const char **errptr) {
+        return readParallel(data, len, errptr, threads);
+    });
+}
+
+bool UniValue::readFile(const std::string &path, std::string_view::size_type *errpos, ReadEngine engine)
+{
+    const MappedFile file(path);
+    return read(file.view(), errpos, engine);
+}
+
+namespace {
+/// A run of whole lines of the input of UniValue::readLines(), which is parsed by one thread.
+struct LineBatch {
+    const char *begin, *end; ///< the lines, including their newlines
+    size_t firstLine;        ///< the line number of the first line
+
+    /// A value read, with its line number, and the end of its line
+    struct Line {
+        size_t line;
+        const char *end;
+        UniValue value;
+    };
+    std::vector<Line> lines{};
+    const char *errpos = nullptr; ///< if a line is invalid, the position of the error (the lines after it are not read)
+    std::exception_ptr exception{}; ///< set if parsing threw (e.g. std::bad_alloc)
+    bool done = false;
+
+    void parse() noexcept
+    {
+        try {
+            size_t line = firstLine;
+            for (const char *p = begin; p < end; ++line) {
+                const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+                if (!eol)
+                    eol = end;
+                if (!std::all_of(p, eol, json_isspace)) {
+                    UniValue value;
+                    if (!value.read(p, eol - p, &errpos))
                         break;
-                    }
-                    UniValue *top = stack.back();
-                    if (top->type() == VOBJ) {
-                        top->var.get<Object>().rbegin()->second = std::move(tmpVal);
-                    } else {
-                        top->var.get<Array>().emplace_back(std::move(tmpVal));
-                    }
+                    lines.push_back({line, eol, std::move(value)});
                 }
+                p = eol + 1;
+            }
+        } catch (...) {
+            exception = std::current_exception();
+        }
+    }
+};
+} // namespace
 
-                setExpect(NOT_VALUE);
-                break;
-                }
+/* static */
+bool UniValue::readLines(std::string_view text, const LineHandler &handler, std::string_view::size_type *errpos,
+                         bool ordered, unsigned threads)
+{
+    // Batches end at the first newline after this many bytes: large enough for the threads to rarely synchronize,
+    // small enough for the in-flight batches to take little memory.
+    constexpr size_t minBatchBytes = 64 * 1024;
+
+    std::vector<LineBatch> batches;
+    for (const char *p = text.data(), * const end = p + text.size(), *next; p < end; p = next) {
+        next = p + std::min<size_t>(minBatchBytes, end - p);
+        if (const void *eol = std::memchr(next - 1, '\n', end - (next - 1)))
+            next = static_cast<const char *>(eol) + 1;
+        else
+            next = end;
+        const size_t firstLine = batches.empty() ? 0 : batches.back().firstLine
+                                                            + std::count(batches.back().begin, batches.back().end, '\n');
+        batches.push_back({p, next, firstLine});
+    }
 
-            default:
-                return nullptr;
+    if (!threads)
+        threads = std::thread::hardware_concurrency();
+    threads = std::min<size_t>(threads, batches.size());
+
+    // The state shared with the worker threads (if any), guarded by `mut`. Workers take the batches in order, but stay
+    // no more than `window` batches ahead of the ones delivered, in order to bound memory use.
+    std::mutex mut;
+    std::condition_variable workAvailable, batchDone;
+    size_t nextBatch = 0, delivered = 0;
+    std::deque<size_t> doneBatches; // in the order they were done
+    bool stop = false;
+    const size_t window = 2 * size_t{threads};
+
+    const auto worker = [&] {
+        for (;;) {
+            size_t b;
+            {
+                std::unique_lock lock(mut);
+                workAvailable.wait(lock, [&] {
+                    return stop || nextBatch == batches.size() || nextBatch < delivered + window;
+                });
+                if (stop || nextBatch == batches.size())
+                    return;
+                b = nextBatch++;
             }
-        } while (!stack.empty());
+            batches[b].parse();
+            {
+                std::lock_guard lock(mut);
+                batches[b].done = true;
+                doneBatches.push_back(b);
+            }
+            batchDone.notify_one();
+        }
+    };
+
+    // Stops and joins the workers however this function exits
+    struct Workers : std::vector<std::thread> {
+        std::mutex &mut;
+        std::condition_variable &workAvailable;
+        bool &stop;
+        Workers(std::mutex &m, std::condition_variable &cv, bool &s) : mut(m), workAvailable(cv), stop(s) {}
+        ~Workers() {
+            {
+                std::lock_guard lock(mut);
+                stop = true;
+            }
+            workAvailable.notify_all();
+            for (auto &thread : *this)
+                thread.join();
+        }
+    } workers(mut, workAvailable, stop);
+    if (threads > 1) {
+        workers.reserve(threads);
+        for (unsigned t = 0; t < threads; ++t)
+            workers.emplace_back(worker);
+    }
+
+    for (size_t i = 0; i < batches.size(); ++i) {
+        size_t b = i;
+        if (threads > 1) {
+            std::unique_lock lock(mut);
+            if (ordered) {
+                batchDone.wait(lock, [&] { return batches[b].done; });
+            } else {
+                batchDone.wait(lock, [&] { return !doneBatches.empty(); });
+                b = doneBatches.front();
+                doneBatches.pop_front();
+            }
+        } else {
+            batches[b].parse();
+        }
+
+        LineBatch &batch = batches[b];
+        if (batch.exception)
+            std::rethrow_exception(batch.exception);
+        for (auto &line : batch.lines) {
+            if (!handler(line.line, std::move(line.value))) {
+                if (errpos) *errpos = line.end - text.data();
+                return false;
+            }
+        }
+        if (batch.errpos) {
+            if (errpos) *errpos = batch.errpos - text.data();
+            return false;
+        }
+        batch.lines = {}; // free the values (which the handler may not have moved from)
+
+        if (threads > 1) {
+            {
+                std::lock_guard lock(mut);
+                ++delivered;
+            }
+            workAvailable.notify_all();
+        }
+    }
+    if (errpos) *errpos = std::string_view::npos;
+    return true;
+}
+
+/* static */
+bool UniValue::readLinesFile(const std::string &path, const LineHandler &handler,
+                             std::string_view::size_type *errpos, bool ordered, unsigned threads)
+{
+    const MappedFile file(path);
+    return readLines(file.view(), handler, errpos, ordered, threads);
+}
+
+const char* UniValue::read(const char* buffer, const char** errpos, ReadEngine engine, std::pmr::memory_resource *mr)
+{
+    return read(buffer, std::strlen(buffer), errpos, engine, mr);
+}
+
+const char* UniValue::read(const char* buffer, size_t len, const char** errpos, ReadEngine engine,
+                           std::pmr::memory_resource *mr)
+{
+    return Parser::read(*this, buffer, len, errpos, engine, mr);
+}
+
+bool UniValue::read(std::string_view raw, std::string_view::size_type *errpos, ReadEngine engine,
+                    std::pmr::memory_resource *mr)
+{
+    return ReadStringView(raw, errpos, [&](const char *data, size_t len, const char **errptr) {
+        return read(data, len, errptr, engine, mr);
+    });
+}
+
+bool UniValue::read(const std::string& raw, std::string::size_type *errpos, ReadEngine engine,
+                    std::pmr::memory_resource *mr)
+{
+    // JSON containing unescaped NUL characters is invalid. Since the read is bounded by the size of the string (rather
+    // than by its terminating NUL), any embedded NULs are simply rejected as unexpected characters.
+    return read(std::string_view{raw}, errpos, engine, mr);
+}
+
+const char* UniValue::readInPlace(const char* buffer, size_t len, const char** errpos, ReadEngine engine)
+{
+    return Parser::read(*this, buffer, len, errpos, engine, resource(), true);
+}
+
+bool UniValue::readInPlace(std::string_view raw, std::string_view::size_type *errpos, ReadEngine engine)
+{
+    return ReadStringView(raw, errpos, [&](const char *data, size_t len, const char **errptr) {
+        return readInPlace(data, len, errptr, engine);
+    });
+}
+
+/* static */
+bool UniValue::readSax(const char* buffer, size_t len, SaxHandler &handler, const char** errpos)
+{
+    const bool ok = TokenReader<SaxSink>(buffer, buffer + len, SaxSink{handler}).read({});
+    if (errpos) *errpos = ok ? nullptr : buffer;
+    return ok;
+}
+
+/* static */
+bool UniValue::readSax(std::string_view raw, SaxHandler &handler, std::string_view::size_type *errpos)
+{
+    return ReadStringView(raw, errpos, [&](const char *data, size_t len, const char **errptr) {
+        return readSax(data, len, handler, errptr) ? data + len : nullptr;
+    });
+}
 
-        /* Check that nothing follows the initial construct (parsed above).  */
-        tok = getJsonToken(tokenVal, buffer);
-        if (tok != JTOK_NONE) {
+/* static */
+bool UniValue::validate(const char* buffer, size_t len, const char** errpos)
+{
+    const bool ok = TokenReader<ValidateSink, NullString>(buffer, buffer + len, ValidateSink{}).read({});
+    if (errpos) *errpos = ok ? nullptr : buffer;
+    return ok;
+}
+
+/* static */
+bool UniValue::validate(std::string_view raw, std::string_view::size_type *errpos)
+{
+    return ReadStringView(raw, errpos, [](const char *data, size_t len, const char **errptr) {
+        return validate(data, len, errptr) ? data + len : nullptr;
+    });
+}
+
+UniValue::Document::Document(size_t initialArenaSize)
+    : arena(initialArenaSize ? initialArenaSize : 4096) {}
+
+void UniValue::Document::clear()
+{
+    value.setNull(); // must be destroyed before the memory it lives in is released
+    arena.release();
+}
+
+const char* UniValue::Document::read(const char* buffer, size_t len, const char** errpos, ReadEngine engine)
+{
+    clear();
+    return Parser::read(value, buffer, len, errpos, engine, &arena);
+}
+
+bool UniValue::Document::read(std::string_view raw, std::string_view::size_type *errpos, ReadEngine engine)
+{
+    return ReadStringView(raw, errpos, [&](const char *data, size_t len, const char **errptr) {
+        return read(data, len, errptr, engine);
+    });
+}
+
+namespace {
+
+[[nodiscard]]
+inline bool json_isdelimiter(char ch) noexcept
+{
+    switch (ch) {
+    case '{': case '}': case '[': case ']': case ':': case ',': case '"':
+        return true;
+    default:
+        return json_isspace(ch);
+    }
+}
+
+/// Returns a pointer just past the closing quote of the string whose contents (following the opening quote) begin at
+/// `p`, or nullptr if [p, end) does not contain it. `escaped` indicates that `p` is preceded by an unpaired backslash.
+const char *FindStringEnd(const char *p, const char * const end, bool escaped)
+{
+    if (escaped) {
+        if (p == end)
             return nullptr;
+        ++p;
+    }
+    for (const char * const start = p; (p = static_cast<const char *>(std::memchr(p, '"', end - p))); ++p) {
+        // the quote is escaped if it is preceded by an odd number of backslashes
+        const char *b = p;
+        while (b != start && b[-1] == '\\')
+            --b;
+        if ((p - b) % 2 == 0)
+            return p + 1;
+    }
+    return nullptr;
+}
+
+/// Returns true if the token that begins at `p` reaches `end`, i.e. if it may continue beyond it.
+bool TokenMayContinue(const char *p, const char * const end)
+{
+    if (*p == '"')
+        return !FindStringEnd(p + 1, end, false);
+    return !json_isdelimiter(*p) && std::find_if(p, end, json_isdelimiter) == end;
+}
+
+} // namespace
+
+UniValue::StreamReader::StreamReader(std::pmr::memory_resource *mr_)
+    : mr(mr_)
+{
+    reset();
+}
+
+void UniValue::StreamReader::reset()
+{
+    value.setNull();
+    stack.clear();
+    slot = &value;
+    state = State::Value;
+    pending.clear();
+    offset = 0;
+    errPos = std::string_view::npos;
+}
+
+bool UniValue::StreamReader::feed(const char *data, size_t len)
+{
+    if (errPos != std::string_view::npos)
+        return false;
+    if (!pending.empty()) {
+        // Complete the token carried over from the previous chunk first
+        const size_t n = pendingTokenEnd(data, len);
+        if (n == std::string::npos) {
+            pending.append(data, len);
+            return true;
         }
+        pending.append(data, n);
+        data += n;
+        len -= n;
+        if (!parse(pending.data(), pending.data() + pending.size(), true))
+            return false;
+        pending.clear();
+    }
+    const char * const end = data + len;
+    const char * const rest = parse(data, end, false);
+    if (!rest)
+        return false;
+    pending.assign(rest, end);
+    return true;
+}
 
-        return buffer;
-#undef expect
-#undef setExpect
-#undef clearExpect
-    }();
+bool UniValue::StreamReader::finish()
+{
+    if (errPos != std::string_view::npos)
+        return false;
+    if (!pending.empty()) {
+        if (!parse(pending.data(), pending.data() + pending.size(), true))
+            return false;
+        pending.clear();
+    }
+    if (state != State::Done) {
+        // The input ended prematurely
+        errPos = offset;
+        return false;
+    }
+    return true;
+}
 
-    // if caller specfied errpos pointer, set it
-    if (errpos) {
-        *errpos = ret == nullptr ? buffer : nullptr;
+/// Returns the number of bytes of `data` that complete the token in `pending`, or std::string::npos if all of them
+/// belong to it and it may still continue.
+size_t UniValue::StreamReader::pendingTokenEnd(const char *data, size_t len) const
+{
+    if (pending.front() == '"') {
+        const auto lastNonBackslash = pending.find_last_not_of('\\'); // the opening quote, at least
+        const bool escaped = (pending.size() - 1 - lastNonBackslash) % 2 != 0;
+        const char * const stringEnd = FindStringEnd(data, data + len, escaped);
+        return stringEnd ? size_t(stringEnd - data) : std::string::npos;
     }
+    // A number or keyword (or junk), which ends at the first delimiter
+    const char * const tokenEnd = std::find_if(data, data + len, json_isdelimiter);
+    return tokenEnd != data + len ? size_t(tokenEnd - data) : std::string::npos;
+}
 
+/// Parses the tokens in [begin, end), and returns a pointer to the incomplete token at its end (or `end`), or nullptr on
+/// error. If `final`, the token at the end is known to be complete.
+const char *UniValue::StreamReader::parse(const char *begin, const char * const end, const bool final)
+{
+    const char *p = begin;
+    std::string_view tokenVal;
+    for (;;) {
+        if (p != end && json_isspace(*p)) // as in getJsonToken(), runs of whitespace are skipped in bulk
+            p = p + 1 != end && json_isspace(p[1]) ? univalue_internal::simd().skipWhitespace(p + 2, end) : p + 1;
+        if (p == end)
+            break;
+
+        const char * const tokenBegin = p;
+        const jtokentype tok = getJsonToken(tokenVal, scratch, p, end);
+        if (!final && (tok == JTOK_ERR || p == end) && TokenMayContinue(tokenBegin, end)) {
+            // Leave a token that may continue in the next chunk (or whose error may be due to it being cut short) for
+            // later
+            p = tokenBegin;
+            break;
+        }
+        bool ok = true, close = false;
+        switch (state) {
+        case State::ArrayFirst:
+            if (tok == JTOK_ARR_CLOSE) {
+                close = true;
+                break;
+            }
+            slot = &ReadElement(Parser::array(*stack.back()), Parser::array(*stack.back()).size());
+            [[fallthrough]];
+        case State::Value:
+            switch (tok) {
+            case JTOK_OBJ_OPEN:
+                stack.push_back(slot);
+                ok = stack.size() <= MAX_JSON_DEPTH;
+                Parser::setObject(*slot, mr);
+                state = State::ObjectFirst;
+                break;
+            case JTOK_ARR_OPEN:
+                stack.push_back(slot);
+                ok = stack.size() <= MAX_JSON_DEPTH;
+                Parser::setArray(*slot, mr);
+                state = State::ArrayFirst;
+                break;
+            case JTOK_STRING:
+                Parser::setStr(*slot, tokenVal);
+                state = stack.empty() ? State::Done : State::Next;
+                break;
+            case JTOK_NUMBER:
+                Parser::setNumStr(*slot, tokenVal);
+                state = stack.empty() ? State::Done : State::Next;
+                break;
+            case JTOK_KW_NULL:
+                slot->setNull();
+                state = stack.empty() ? State::Done : State::Next;
+                break;
+            case JTOK_KW_TRUE:
+            case JTOK_KW_FALSE:
+                *slot = tok == JTOK_KW_TRUE;
+                state = stack.empty() ? State::Done : State::Next;
+                break;
+            default:
+                ok = false;
+            }
+            break;
+        case State::ObjectFirst:
+            if (tok == JTOK_OBJ_CLOSE) {
+                close = true;
+                break;
+            }
+            [[fallthrough]];
+        case State::Key:
+            if (tok == JTOK_STRING) {
+                UniValue::Object &obj = Parser::object(*stack.back());
+                slot = &ReadMember(obj, obj.size(), tokenVal);
+                state = State::Colon;
+            } else
+                ok = false;
+            break;
+        case State::Colon:
+            ok = tok == JTOK_COLON;
+            state = State::Value;
+            break;
+        case State::Next:
+            if (tok == JTOK_COMMA) {
+                if (stack.back()->isObject())
+                    state = State::Key;
+                else {
+                    slot = &ReadElement(Parser::array(*stack.back()), Parser::array(*stack.back()).size());
+                    state = State::Value;
+                }
+            } else
+                ok = close = tok == (stack.back()->isObject() ? JTOK_OBJ_CLOSE : JTOK_ARR_CLOSE);
+            break;
+        case State::Done:
+            ok = false; // junk after the document
+            break;
+        }
+        if (!ok) {
+            errPos = offset + (p - begin);
+            return nullptr;
+        }
+        if (close) {
+            stack.pop_back();
+            state = stack.empty() ? State::Done : State::Next;
+        }
+    }
+    offset += p - begin;
+    return p;
+}
+
+/// The sink of TokenReader that builds the index of a LazyDocument.
+struct UniValue::LazyDocument::IndexSink {
+    struct Value {};
+    using Object = size_t; // ordinal
+    using Array = size_t;
+
+    const char * const &buffer; // the position of the reader
+    const char * const begin;
+    std::vector<Container> &containers;
+
+    bool start(size_t &ordinal) {
+        ordinal = containers.size();
+        containers.emplace_back();
+        return true;
+    }
+    bool finish(size_t ordinal, size_t n) {
+        containers[ordinal] = {size_t(buffer - begin), n, containers.size()};
+        return true;
+    }
+    bool startObject(Value, Object &obj) { return start(obj); }
+    bool key(Object, size_t, std::string_view, Value &) { return true; }
+    bool endObject(Object obj, size_t n) { return finish(obj, n); }
+    bool startArray(Value, Array &arr) { return start(arr); }
+    bool element(Array, size_t, Value &) { return true; }
+    bool endArray(Array arr, size_t n) { return finish(arr, n); }
+    bool skip(Value) const { return false; }
+    bool string(Value, std::string_view) { return true; }
+    bool number(Value, std::string_view) { return true; }
+    bool null(Value) { return true; }
+    bool boolean(Value, bool) { return true; }
+};
+
+bool UniValue::LazyDocument::read(std::string_view raw, std::string_view::size_type *errpos)
+{
+    clear();
+    const char *buffer = raw.data();
+    // (the index has no use for the text of strings, so those with escapes are only validated, not unescaped)
+    const bool ok = TokenReader<IndexSink, NullString>(buffer, raw.data() + raw.size(),
+                                                       IndexSink{buffer, raw.data(), containers}).read({});
+    if (errpos) *errpos = ok ? std::string_view::npos : static_cast<std::string_view::size_type>(buffer - raw.data());
+    if (!ok) {
+        clear();
+        return false;
+    }
+    json = raw;
+    rootPos = std::find_if_not(raw.begin(), raw.end(), json_isspace) - raw.begin();
+    return true;
+}
+
+void UniValue::LazyDocument::clear() noexcept
+{
+    json = {};
+    rootPos = 0;
+    containers.clear();
+}
+
+namespace {
+/// Returns a pointer just past the (valid) scalar value that begins at `p`.
+const char *SkipScalar(const char *p, const char *end)
+{
+    return *p == '"' ? FindStringEnd(p + 1, end, false) : std::find_if(p, end, json_isdelimiter);
+}
+
+/// Returns a pointer to the first non-whitespace character at or after `p`.
+const char *SkipSpace(const char *p, const char *end)
+{
+    return std::find_if_not(p, end, json_isspace);
+}
+} // namespace
+
+UniValue::VType UniValue::LazyValue::type() const noexcept
+{
+    if (!doc)
+        return VNULL;
+    switch (doc->json[pos]) {
+    case '{': return VOBJ;
+    case '[': return VARR;
+    case '"': return VSTR;
+    case 'n': return VNULL;
+    case 't': return VTRUE;
+    case 'f': return VFALSE;
+    default: return VNUM;
+    }
+}
+
+UniValue::size_type UniValue::LazyValue::size() const noexcept
+{
+    return is(VOBJ | VARR) ? doc->containers[ordinal].size : 0;
+}
+
+UniValue::LazyValue::iterator UniValue::LazyValue::begin() const
+{
+    iterator it;
+    if (is(VOBJ | VARR)) {
+        it.value.doc = doc;
+        it.next = pos + 1;
+        it.nextOrdinal = ordinal + 1;
+        it.object = isObject();
+        it.advance();
+    }
+    return it;
+}
+
+UniValue::LazyValue::iterator UniValue::LazyValue::end() const noexcept { return {}; }
+
+void UniValue::LazyValue::iterator::advance()
+{
+    const LazyDocument &d = *value.doc;
+    const char * const begin = d.json.data(), * const end = begin + d.json.size();
+    // The input is known to be valid, so this only needs to tell the tokens apart
+    const char *p = SkipSpace(begin + next, end);
+    if (*p == ',')
+        p = SkipSpace(p + 1, end);
+    else if (*p == '}' || *p == ']') {
+        value = {};
+        return;
+    }
+    if (object) {
+        keyPos = p - begin;
+        p = SkipSpace(FindStringEnd(p + 1, end, false), end); // the colon
+        p = SkipSpace(p + 1, end);
+    }
+    value.pos = p - begin;
+    value.ordinal = nextOrdinal;
+    if (*p == '{' || *p == '[') {
+        next = d.containers[nextOrdinal].end;
+        nextOrdinal = d.containers[nextOrdinal].next;
+    } else
+        next = SkipScalar(p, end) - begin;
+}
+
+std::string_view UniValue::LazyValue::iterator::key() const
+{
+    if (!object || !value.doc)
+        return {};
+    const char *p = value.doc->json.data() + keyPos;
+    std::string_view key;
+    getJsonToken(key, scratch, p, value.doc->json.data() + value.doc->json.size());
+    return key;
+}
+
+std::optional<UniValue::LazyValue> UniValue::LazyValue::locate(std::string_view key) const
+{
+    if (isObject())
+        for (auto it = begin(); it != end(); ++it)
+            if (it.key() == key)
+                return *it;
+    return std::nullopt;
+}
+
+UniValue::LazyValue UniValue::LazyValue::operator[](std::string_view key) const
+{
+    return locate(key).value_or(LazyValue{});
+}
+
+UniValue::LazyValue UniValue::LazyValue::operator[](size_type index) const
+{
+    if (index >= size())
+        return {};
+    auto it = begin();
+    while (index--)
+        ++it;
+    return *it;
+}
+
+UniValue::LazyValue UniValue::LazyValue::at(std::string_view key) const
+{
+    if (!isObject())
+        throw std::domain_error(std::string("Cannot look up keys in JSON ") + typeName(type()) +
+                                ", expected object with key: " + std::string(key));
+    if (auto found = locate(key))
+        return *found;
+    throw std::out_of_range("Key not found in JSON object: " + std::string(key));
+}
+
+UniValue::LazyValue UniValue::LazyValue::at(size_type index) const
+{
+    if (!is(VOBJ | VARR))
+        throw std::domain_error(std::string("Cannot look up indices in JSON ") + typeName(type()) +
+                                ", expected array or object larger than " + std::to_string(index) + " elements");
+    if (index >= size())
+        throw std::out_of_range("Index " + std::to_string(index) + " out of range in JSON " + typeName(type())
+                                + " of length " + std::to_string(size()));
+    return (*this)[index];
+}
+
+UniValue UniValue::LazyValue::materialize() const
+{
+    UniValue ret;
+    if (!doc)
+        return ret;
+    const char * const begin = doc->json.data() + pos, * const end = doc->json.data() + doc->json.size();
+    const char * const valueEnd = is(VOBJ | VARR) ? doc->json.data() + doc->containers[ordinal].end
+                                                  : SkipScalar(begin, end);
+    const bool ok = ret.read(begin, valueEnd - begin, nullptr, ReadEngine::Tokenizer) != nullptr;
+    assert(ok); // the input was already validated
+    (void)ok;
     return ret;
 }
 
-bool UniValue::read(const std::string& raw, std::string::size_type *errpos)
+bool UniValue::LazyValue::get_bool() const { return materialize().get_bool(); }
+int UniValue::LazyValue::get_int() const { return materialize().get_int(); }
+int64_t UniValue::LazyValue::get_int64() const { return materialize().get_int64(); }
+unsigned UniValue::LazyValue::get_uint() const { return materialize().get_uint(); }
+uint64_t UniValue::LazyValue::get_uint64() const { return materialize().get_uint64(); }
+double UniValue::LazyValue::get_real() const { return materialize().get_real(); }
+int64_t UniValue::LazyValue::get_fixed(unsigned decimals) const { return materialize().get_fixed(decimals); }
+std::string UniValue::LazyValue::get_str() const { return materialize().get_str(); }
+std::string UniValue::LazyValue::getValStr() const { return materialize().getValStr(); }
+
+UniValue::PathFilter::PathFilter(const std::vector<std::string_view> &paths)
 {
-    // JSON containing unescaped NUL characters is invalid.
-    // std::string is NUL-terminated but may also contain NULs within its size.
-    // So read until the first NUL character, and then verify that this is indeed the terminating NUL.
-    const char* errptr;
-    const char* const res = read(raw.data(), &errptr);
-    if (errpos) *errpos = errptr ? errptr - raw.data() : std::string::npos;
-    if (res == raw.data() + raw.size()) {
-        // parsing consumed entire string (no embedded NULs), success
+    // First, the paths as a trie. This is nondeterministic, since a key may match both a named child and "*".
+    struct Node {
+        std::map<std::string, size_t, std::less<>> children;
+        size_t any = npos; ///< the child for "*"
+        bool selected = false;
+    };
+    std::vector<Node> nodes(1);
+    for (const std::string_view path : paths) {
+        if (!path.empty() && path.front() != '/')
+            throw std::invalid_argument("UniValue::PathFilter: a path must be empty or begin with '/': "
+                                        + std::string(path));
+        size_t node = 0;
+        for (size_t pos = 0; pos < path.size();) {
+            const size_t end = std::min(path.find('/', pos + 1), path.size());
+            const std::string_view component = path.substr(pos + 1, end - pos - 1);
+            pos = end;
+            if (component == "*") {
+                if (nodes[node].any == npos) {
+                    nodes[node].any = nodes.size();
+                    nodes.emplace_back();
+                }
+                node = nodes[node].any;
+                continue;
+            }
+            std::string key;
+            for (size_t i = 0; i < component.size(); ++i) {
+                if (component[i] != '~') {
+                    key += component[i];
+                } else if (i + 1 < component.size() && (component[i + 1] == '0' || component[i + 1] == '1')) {
+                    key += component[++i] == '0' ? '~' : '/';
+                } else {
+                    throw std::invalid_argument("UniValue::PathFilter: '~' must be followed by '0' or '1': "
+                                                + std::string(path));
+                }
+            }
+            const auto [it, inserted] = nodes[node].children.try_emplace(std::move(key), nodes.size());
+            const size_t child = it->second;
+            if (inserted)
+                nodes.emplace_back();
+            node = child;
+        }
+        nodes[node].selected = true;
+    }
+
+    // Then the deterministic automaton, each state of which is a set of nodes of the trie (the subset construction)
+    std::map<std::vector<size_t>, size_t> stateOfSet;
+    std::vector<std::vector<size_t>> sets;
+    const auto stateOf = [&](std::vector<size_t> set) {
+        if (set.empty())
+            return npos;
+        std::sort(set.begin(), set.end());
+        set.erase(std::unique(set.begin(), set.end()), set.end());
+        const auto [it, inserted] = stateOfSet.try_emplace(set, sets.size());
+        if (inserted)
+            sets.push_back(std::move(set));
+        return it->second;
+    };
+    stateOf({0});
+    for (size_t i = 0; i < sets.size(); ++i) { // sets grows as new states are discovered
+        const std::vector<size_t> set = sets[i];
+        State state;
+        for (const size_t n : set)
+            state.selected = state.selected || nodes[n].selected;
+        if (!state.selected) { // (everything within a selected value is selected, so it needs no transitions)
+            std::vector<size_t> other;
+            std::vector<std::string_view> keys;
+            for (const size_t n : set) {
+                if (nodes[n].any != npos)
+                    other.push_back(nodes[n].any);
+                for (const auto &child : nodes[n].children)
+                    keys.push_back(child.first);
+            }
+            std::sort(keys.begin(), keys.end());
+            keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+            for (const std::string_view key : keys) {
+                std::vector<size_t> next = other;
+                for (const size_t n : set)
+                    if (const auto it = nodes[n].children.find(key); it != nodes[n].children.end())
+                        next.push_back(it->second);
+                state.keys.emplace_back(key, stateOf(std::move(next)));
+            }
+            state.other = stateOf(std::move(other));
+        }
+        states.push_back(std::move(state));
+    }
+}
+
+size_t UniValue::PathFilter::next(size_t state, std::string_view key) const noexcept
+{
+    const State &s = states[state];
+    if (s.selected)
+        return state;
+    const auto it = std::lower_bound(s.keys.begin(), s.keys.end(), key,
+                                     [](const auto &entry, std::string_view k) { return entry.first < k; });
+    return it != s.keys.end() && it->first == key ? it->second : s.other;
+}
+
+namespace {
+/**
+ * The sink of TokenReader that implements UniValue::readFiltered(): like DomSink, but only for the values selected by
+ * the filter, and the objects and arrays on the way to them. Never stops the reader.
+ */
+struct FilterSink {
+    struct Value {
+        UniValue *uv = nullptr;     ///< where to read the value, or nullptr to skip it
+        size_t state = 0;           ///< the state of the value in the filter
+        UniValue *parent = nullptr; ///< the object or array that has the value as its last member or element, if any
+    };
+    using Object = Value;
+    using Array = Value;
+
+    const UniValue::PathFilter &filter;
+
+    /// Removes `v`, which turned out to contain nothing selected, from the result
+    static void drop(const Value &v) {
+        if (!v.parent) {
+            v.uv->setNull();
+        } else if (v.parent->isObject()) {
+            auto &obj = UniValue::Parser::object(*v.parent);
+            obj.erase(obj.end() - 1, obj.end());
+        } else {
+            auto &arr = UniValue::Parser::array(*v.parent);
+            arr.erase(arr.end() - 1, arr.end());
+        }
+    }
+    /// Returns true if the scalar `v` is to be read, otherwise drops it if needed
+    bool keep(const Value &v) const {
+        if (!v.uv)
+            return false;
+        if (filter.isSelected(v.state))
+            return true;
+        drop(v);
+        return false;
+    }
+
+    bool startObject(Value v, Object &obj) {
+        if (v.uv)
+            UniValue::Parser::setObject(*v.uv, nullptr);
+        obj = v;
+        return true;
+    }
+    bool key(Object obj, size_t, std::string_view key, Value &v) {
+        v = {};
+        if (obj.uv) {
+            if (const size_t state = filter.next(obj.state, key); state != UniValue::PathFilter::npos) {
+                auto &o = UniValue::Parser::object(*obj.uv);
+                v = {&ReadMember(o, o.size(), key), state, obj.uv};
+            }
+        }
+        return true;
+    }
+    bool endObject(Object obj, size_t) {
+        if (obj.uv && !filter.isSelected(obj.state) && UniValue::Parser::object(*obj.uv).empty())
+            drop(obj);
         return true;
-    } else if (!errptr && errpos && res) {
-        // Embedded NUL, but no parse error, however parsing is incomplete because it did not consume the entire string.
-        // Update errpos accordingly to point to parse end.
-        *errpos = res - raw.data();
     }
-    return false;
+    bool startArray(Value v, Array &arr) {
+        if (v.uv)
+            UniValue::Parser::setArray(*v.uv, nullptr);
+        arr = v;
+        return true;
+    }
+    bool element(Array arr, size_t n, Value &v) {
+        v = {};
+        if (arr.uv) {
+            char index[std::numeric_limits<size_t>::digits10 + 1];
+            const std::string_view key(index, std::to_chars(index, index + sizeof(index), n).ptr - index);
+            if (const size_t state = filter.next(arr.state, key); state != UniValue::PathFilter::npos) {
+                auto &a = UniValue::Parser::array(*arr.uv);
+                v = {&ReadElement(a, a.size()), state, arr.uv};
+            }
+        }
+        return true;
+    }
+    bool endArray(Array arr, size_t) {
+        if (arr.uv && !filter.isSelected(arr.state) && UniValue::Parser::array(*arr.uv).empty())
+            drop(arr);
+        return true;
+    }
+    bool string(Value v, std::string_view s) { if (keep(v)) UniValue::Parser::setStr(*v.uv, s); return true; }
+    bool number(Value v, std::string_view s) { if (keep(v)) UniValue::Parser::setNumStr(*v.uv, s); return true; }
+    bool skip(Value v) const { return !v.uv; }
+    bool null(Value v) { keep(v); return true; }
+    bool boolean(Value v, bool b) { if (keep(v)) *v.uv = b; return true; }
+};
+} // namespace
+
+const char* UniValue::readFiltered(const char* buffer, size_t len, const PathFilter &filter, const char** errpos)
+{
+    setNull();
+    const bool ok = TokenReader<FilterSink>(buffer, buffer + len, FilterSink{filter}).read({this, 0, nullptr});
+    if (errpos) *errpos = ok ? nullptr : buffer;
+    return ok ? buffer : nullptr;
+}
+
+bool UniValue::readFiltered(std::string_view raw, const PathFilter &filter, std::string_view::size_type *errpos)
+{
+    return ReadStringView(raw, errpos, [&](const char *data, size_t len, const char **errptr) {
+        return readFiltered(data, len, filter, errptr);
+    });
 }
@@ -0,0 +1,1135 @@
+// Copyright (c) 2026 Calin A. Culianu <calin.culianu@gmail.com>
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://opensource.org/licenses/mit-license.php.
+
+#include "univalue.h"
+#include "univalue_simd.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if !defined(UNIVALUE_NO_SIMD)
+#if (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)) \
+    && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#define UNIVALUE_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && (defined(__GNUC__) || defined(__clang__))
+#define UNIVALUE_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+#endif // !defined(UNIVALUE_NO_SIMD)
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// MSVC makes all intrinsics available regardless of the target architecture flags
+#define UNIVALUE_TARGET(isa)
+#define UNIVALUE_NO_SANITIZE_ADDRESS
+#else
+// Allows compiling each kernel for its instruction set without requiring e.g. -mavx2 for the whole library
+#define UNIVALUE_TARGET(isa) __attribute__((target(isa)))
+// The scanning kernels intentionally read the whole aligned blocks overlapping their input, which may extend past it
+// (into memory that the sanitizers may consider freed, or owned by another thread)
+#define UNIVALUE_NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address, no_sanitize_thread))
+#endif
+
+namespace univalue_internal {
+namespace {
+
+[[maybe_unused]]
+inline unsigned CountTrailingZeros(uint64_t mask) noexcept
+{
+    assert(mask != 0);
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long idx;
+#if defined(_M_X64)
+    _BitScanForward64(&idx, mask);
+#else
+    if (!_BitScanForward(&idx, static_cast<uint32_t>(mask))) {
+        _BitScanForward(&idx, static_cast<uint32_t>(mask >> 32));
+        idx += 32;
+    }
+#endif
+    return static_cast<unsigned>(idx);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(mask));
+#endif
+}
+
+// --- Scalar kernels (these are also used to process the tails of bounded buffers in the SIMD kernels) ---
+
+inline constexpr bool IsStringSpecial(uint8_t ch) noexcept { return ch == '"' || ch == '\\' || ch < 0x20 || ch >= 0x80; }
+inline constexpr bool IsStringEnd(uint8_t ch) noexcept { return ch == '"' || ch == '\\' || ch < 0x20; }
+inline constexpr bool IsSpace(uint8_t ch) noexcept { return ch == 0x20 || ch == 0x09 || ch == 0x0a || ch == 0x0d; }
+inline constexpr bool NeedsEscape(uint8_t ch) noexcept { return ch < 0x20 || ch == '"' || ch == '\\' || ch == 0x7f; }
+
+const char *FindStringSpecialScalar(const char *p, const char *end) noexcept
+{
+    while (p < end && !IsStringSpecial(static_cast<uint8_t>(*p)))
+        ++p;
+    return p;
+}
+
+const char *FindStringEndScalar(const char *p, const char *end) noexcept
+{
+    while (p < end && !IsStringEnd(static_cast<uint8_t>(*p)))
+        ++p;
+    return p;
+}
+
+const char *SkipWhitespaceScalar(const char *p, const char *end) noexcept
+{
+    while (p < end && IsSpace(static_cast<uint8_t>(*p)))
+        ++p;
+    return p;
+}
+
+const char *FindEscapeCharScalar(const char *p, const char *end) noexcept
+{
+    while (p < end && !NeedsEscape(static_cast<uint8_t>(*p)))
+        ++p;
+    return p;
+}
+
+/// Returns the length of the well-formed UTF-8 sequence starting at `p` (1 for ASCII), or 0 if the sequence is
+/// ill-formed or truncated by `end`.
+inline size_t Utf8SequenceLength(const uint8_t *p, const uint8_t *end) noexcept
+{
+    const uint8_t lead = *p;
+    if (lead < 0x80)
+        return 1;
+    size_t len;
+    uint8_t lo = 0x80, hi = 0xbf; // the permitted range of the 2nd byte (narrower for some lead bytes)
+    if (lead >= 0xc2 && lead <= 0xdf) {
+        len = 2;
+    } else if (lead >= 0xe0 && lead <= 0xef) {
+        len = 3;
+        if (lead == 0xe0) lo = 0xa0; // overlong
+        else if (lead == 0xed) hi = 0x9f; // surrogates
+    } else if (lead >= 0xf0 && lead <= 0xf4) {
+        len = 4;
+        if (lead == 0xf0) lo = 0x90; // overlong
+        else if (lead == 0xf4) hi = 0x8f; // > U+10FFFF
+    } else {
+        return 0; // continuation byte, overlong 2-byte lead (0xc0, 0xc1), or a lead byte for > U+10FFFF
+    }
+    if (static_cast<size_t>(end - p) < len || p[1] < lo || p[1] > hi)
+        return 0;
+    for (size_t i = 2; i < len; ++i)
+        if ((p[i] & 0xc0) != 0x80)
+            return 0;
+    return len;
+}
+
+bool ValidUtf8Scalar(const char *p, const char *end) noexcept
+{
+    auto *up = reinterpret_cast<const uint8_t *>(p), *uend = reinterpret_cast<const uint8_t *>(end);
+    while (up < uend) {
+        const size_t len = Utf8SequenceLength(up, uend);
+        if (!len)
+            return false;
+        up += len;
+    }
+    return true;
+}
+
+void Classify64Scalar(const char *p, BlockClasses &out) noexcept
+{
+    out = {};
+    for (unsigned i = 0; i < 64; ++i) {
+        const uint64_t bit = uint64_t{1} << i;
+        switch (p[i]) {
+        case '\\': out.backslash |= bit; break;
+        case '"': out.quote |= bit; break;
+        case ' ': case '\t': case '\n': case '\r': out.space |= bit; break;
+        case '{': case '}': case '[': case ']': case ':': case ',': out.op |= bit; break;
+        default: break;
+        }
+    }
+}
+
+constexpr SimdKernels scalarKernels = {
+    "scalar", FindStringSpecialScalar, FindStringEndScalar, SkipWhitespaceScalar, FindEscapeCharScalar,
+    ValidUtf8Scalar, Classify64Scalar,
+};
+
+#if defined(UNIVALUE_SIMD_X86)
+
+// --- SSE2 kernels ---
+
+// Bytes >= 0x80 are negative when viewed as int8, so a single signed compare against 0x20 catches both the control
+// characters and the non-ASCII bytes. An unsigned compare (via min) catches just the control characters.
+
+UNIVALUE_TARGET("sse2") UNIVALUE_NO_SANITIZE_ADDRESS
+inline uint32_t StringSpecialMaskSse2(const char *block) noexcept
+{
+    const __m128i v = _mm_load_si128(reinterpret_cast<const __m128i *>(block));
+    const __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+                                                _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+                                   _mm_cmplt_epi8(v, _mm_set1_epi8(0x20)));
+    return static_cast<uint32_t>(_mm_movemask_epi8(m));
+}
+
+UNIVALUE_TARGET("sse2") UNIVALUE_NO_SANITIZE_ADDRESS
+inline uint32_t StringEndMaskSse2(const char *block) noexcept
+{
+    const __m128i v = _mm_load_si128(reinterpret_cast<const __m128i *>(block));
+    const __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+                                                _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+                                   _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(0x1f)), v));
+    return static_cast<uint32_t>(_mm_movemask_epi8(m));
+}
+
+UNIVALUE_TARGET("sse2") UNIVALUE_NO_SANITIZE_ADDRESS
+inline uint32_t NonSpaceMaskSse2(const char *block) noexcept
+{
+    const __m128i v = _mm_load_si128(reinterpret_cast<const __m128i *>(block));
+    const __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(0x20)),
+                                                _mm_cmpeq_epi8(v, _mm_set1_epi8(0x09))),
+                                   _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(0x0a)),
+                                                _mm_cmpeq_epi8(v, _mm_set1_epi8(0x0d))));
+    return ~static_cast<uint32_t>(_mm_movemask_epi8(m)) & 0xffffu;
+}
+
+UNIVALUE_TARGET("sse2")
+inline uint32_t EscapeMaskSse2(const char *p) noexcept
+{
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    const __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+                                                _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+                                   _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(0x1f)), v),
+                                                _mm_cmpeq_epi8(v, _mm_set1_epi8(0x7f))));
+    return static_cast<uint32_t>(_mm_movemask_epi8(m));
+}
+
+UNIVALUE_TARGET("sse2") UNIVALUE_NO_SANITIZE_ADDRESS
+const char *FindStringSpecialSse2(const char *p, const char *end) noexcept
+{
+    if (p >= end)
+        return end;
+    const size_t misalign = reinterpret_cast<uintptr_t>(p) & 15u;
+    const char *block = p - misalign;
+    uint32_t mask = StringSpecialMaskSse2(block) >> misalign;
+    while (!mask) {
+        block += 16;
+        if (block >= end)
+            return end;
+        p = block;
+        mask = StringSpecialMaskSse2(block);
+    }
+    return std::min(p + CountTrailingZeros(mask), end);
+}
+
+UNIVALUE_TARGET("sse2") UNIVALUE_NO_SANITIZE_ADDRESS
+const char *FindStringEndSse2(const char *p, const char *end) noexcept
+{
+    if (p >= end)
+        return end;
+    const size_t misalign = reinterpret_cast<uintptr_t>(p) & 15u;
+    const char *block = p - misalign;
+    uint32_t mask = StringEndMaskSse2(block) >> misalign;
+    while (!mask) {
+        block += 16;
+        if (block >= end)
+            return end;
+        p = block;
+        mask = StringEndMaskSse2(block);
+    }
+    return std::min(p + CountTrailingZeros(mask), end);
+}
+
+UNIVALUE_TARGET("sse2") UNIVALUE_NO_SANITIZE_ADDRESS
+const char *SkipWhitespaceSse2(const char *p, const char *end) noexcept
+{
+    if (p >= end)
+        return end;
+    const size_t misalign = reinterpret_cast<uintptr_t>(p) & 15u;
+    const char *block = p - misalign;
+    uint32_t mask = NonSpaceMaskSse2(block) >> misalign;
+    while (!mask) {
+        block += 16;
+        if (block >= end)
+            return end;
+        p = block;
+        mask = NonSpaceMaskSse2(block);
+    }
+    return std::min(p + CountTrailingZeros(mask), end);
+}
+
+UNIVALUE_TARGET("sse2")
+const char *FindEscapeCharSse2(const char *p, const char *end) noexcept
+{
+    for (; end - p >= 16; p += 16)
+        if (const uint32_t mask = EscapeMaskSse2(p))
+            return p + CountTrailingZeros(mask);
+    return FindEscapeCharScalar(p, end);
+}
+
+UNIVALUE_TARGET("sse2")
+bool ValidUtf8Sse2(const char *p, const char *end) noexcept
+{
+    // Skip ASCII 16 bytes at a time, and validate the multi-byte sequences one at a time
+    auto *up = reinterpret_cast<const uint8_t *>(p), *uend = reinterpret_cast<const uint8_t *>(end);
+    while (up < uend) {
+        if (uend - up >= 16 && !_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(up)))) {
+            up += 16;
+            continue;
+        }
+        const size_t len = Utf8SequenceLength(up, uend);
+        if (!len)
+            return false;
+        up += len;
+    }
+    return true;
+}
+
+UNIVALUE_TARGET("sse2")
+void Classify64Sse2(const char *p, BlockClasses &out) noexcept
+{
+    out = {};
+    for (unsigned i = 0; i < 64; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+        // '{' | 0x20 == '{', '[' | 0x20 == '{', and likewise for '}' and ']'
+        const __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        const __m128i op = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(lower, _mm_set1_epi8('{')),
+                                                     _mm_cmpeq_epi8(lower, _mm_set1_epi8('}'))),
+                                        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')),
+                                                     _mm_cmpeq_epi8(v, _mm_set1_epi8(','))));
+        const __m128i space = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(0x20)),
+                                                        _mm_cmpeq_epi8(v, _mm_set1_epi8(0x09))),
+                                           _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(0x0a)),
+                                                        _mm_cmpeq_epi8(v, _mm_set1_epi8(0x0d))));
+        out.backslash |= uint64_t(uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))))) << i;
+        out.quote |= uint64_t(uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"'))))) << i;
+        out.space |= uint64_t(uint32_t(_mm_movemask_epi8(space))) << i;
+        out.op |= uint64_t(uint32_t(_mm_movemask_epi8(op))) << i;
+    }
+}
+
+constexpr SimdKernels sse2Kernels = {
+    "sse2", FindStringSpecialSse2, FindStringEndSse2, SkipWhitespaceSse2, FindEscapeCharSse2, ValidUtf8Sse2,
+    Classify64Sse2,
+};
+
+// --- AVX2 kernels ---
+
+UNIVALUE_TARGET("avx2") UNIVALUE_NO_SANITIZE_ADDRESS
+inline uint32_t StringSpecialMaskAvx2(const char *block) noexcept
+{
+    const __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i *>(block));
+    const __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')),
+                                                      _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))),
+                                      _mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), v));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(m));
+}
+
+UNIVALUE_TARGET("avx2") UNIVALUE_NO_SANITIZE_ADDRESS
+inline uint32_t StringEndMaskAvx2(const char *block) noexcept
+{
+    const __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i *>(block));
+    const __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')),
+                                                      _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))),
+                                      _mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(0x1f)), v));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(m));
+}
+
+UNIVALUE_TARGET("avx2") UNIVALUE_NO_SANITIZE_ADDRESS
+inline uint32_t NonSpaceMaskAvx2(const char *block) noexcept
+{
+    const __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i *>(block));
+    const __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x20)),
+                                                      _mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x09))),
+                                      _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x0a)),
+                                                      _mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x0d))));
+    return ~static_cast<uint32_t>(_mm256_movemask_epi8(m));
+}
+
+UNIVALUE_TARGET("avx2")
+inline uint32_t EscapeMaskAvx2(const char *p) noexcept
+{
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    const __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')),
+                                                      _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))),
+                                      _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(0x1f)), v),
+                                                      _mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x7f))));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(m));
+}
+
+UNIVALUE_TARGET("avx2") UNIVALUE_NO_SANITIZE_ADDRESS
+const char *FindStringSpecialAvx2(const char *p, const char *end) noexcept
+{
+    if (p >= end)
+        return end;
+    const size_t misalign = reinterpret_cast<uintptr_t>(p) & 31u;
+    const char *block = p - misalign;
+    uint32_t mask = StringSpecialMaskAvx2(block) >> misalign;
+    while (!mask) {
+        block += 32;
+        if (block >= end)
+            return end;
+        p = block;
+        mask = StringSpecialMaskAvx2(block);
+    }
+    return std::min(p + CountTrailingZeros(mask), end);
+}
+
+UNIVALUE_TARGET("avx2") UNIVALUE_NO_SANITIZE_ADDRESS
+const char *FindStringEndAvx2(const char *p, const char *end) noexcept
+{
+    if (p >= end)
+        return end;
+    const size_t misalign = reinterpret_cast<uintptr_t>(p) & 31u;
+    const char *block = p - misalign;
+    uint32_t mask = StringEndMaskAvx2(block) >> misalign;
+    while (!mask) {
+        block += 32;
+        if (block >= end)
+            return end;
+        p = block;
+        mask = StringEndMaskAvx2(block);
+    }
+    return std::min(p + CountTrailingZeros(mask), end);
+}
+
+UNIVALUE_TARGET("avx2") UNIVALUE_NO_SANITIZE_ADDRESS
+const char *SkipWhitespaceAvx2(const char *p, const char *end) noexcept
+{
+    if (p >= end)
+        return end;
+    const size_t misalign = reinterpret_cast<uintptr_t>(p) & 31u;
+    const char *block = p - misalign;
+    uint32_t mask = NonSpaceMaskAvx2(block) >> misalign;
+    while (!mask) {
+        block += 32;
+        if (block >= end)
+            return end;
+        p = block;
+        mask = NonSpaceMaskAvx2(block);
+    }
+    return std::min(p + CountTrailingZeros(mask), end);
+}
+
+UNIVALUE_TARGET("avx2")
+const char *FindEscapeCharAvx2(const char *p, const char *end) noexcept
+{
+    for (; end - p >= 32; p += 32)
+        if (const uint32_t mask = EscapeMaskAvx2(p))
+            return p + CountTrailingZeros(mask);
+    return FindEscapeCharSse2(p, end);
+}
+
+// UTF-8 validation using the "lookup" algorithm of Keiser & Lemire, "Validating UTF-8 In Less Than One Instruction
+// Per Byte" (2021). Each byte is classified by three 16-entry table lookups (on the high nibble of the previous
+// byte, the low nibble of the previous byte, and the high nibble of the current byte). The bitwise AND of the three
+// results is non-zero for every 2-byte error pattern; 3 and 4 byte sequences are then checked by looking back 2
+// and 3 bytes for lead bytes that demand continuation bytes.
+namespace utf8 {
+constexpr uint8_t TOO_SHORT = 1 << 0; // 11______ 0_______ or 11______ 11______
+constexpr uint8_t TOO_LONG = 1 << 1; // 0_______ 10______
+constexpr uint8_t OVERLONG_3 = 1 << 2; // 11100000 100_____
+constexpr uint8_t TOO_LARGE = 1 << 3; // 11110100 1001____ or 11110100 101_____ or 11110101+ 10______
+constexpr uint8_t SURROGATE = 1 << 4; // 11101101 101_____
+constexpr uint8_t OVERLONG_2 = 1 << 5; // 1100000_ 10______
+constexpr uint8_t TWO_CONTS = 1 << 7; // 10______ 10______
+constexpr uint8_t TOO_LARGE_1000 = 1 << 6; // 11110101+ 1000____
+constexpr uint8_t OVERLONG_4 = 1 << 6; // 11110000 1000____
+constexpr uint8_t CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+constexpr uint8_t byte1High[16] = {
+    // 0_______ ________ <ASCII in byte 1>
+    TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+    // 10______ ________ <continuation in byte 1>
+    TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+    // 1100____ ________ <two byte lead in byte 1>
+    TOO_SHORT | OVERLONG_2,
+    // 1101____ ________ <two byte lead in byte 1>
+    TOO_SHORT,
+    // 1110____ ________ <three byte lead in byte 1>
+    TOO_SHORT | OVERLONG_3 | SURROGATE,
+    // 1111____ ________ <four+ byte lead in byte 1>
+    TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4,
+};
+constexpr uint8_t byte1Low[16] = {
+    // ____0000 ________
+    CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+    // ____0001 ________
+    CARRY | OVERLONG_2,
+    // ____001_ ________
+    CARRY, CARRY,
+    // ____0100 ________
+    CARRY | TOO_LARGE,
+    // ____0101 ________
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    // ____011_ ________
+    CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+    // ____1___ ________
+    CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    // ____1101 ________
+    CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+    CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+};
+constexpr uint8_t byte2High[16] = {
+    // ________ 0_______ <ASCII in byte 2>
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+    // ________ 1000____
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+    // ________ 1001____
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+    // ________ 101_____
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+    // ________ 11______
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+};
+} // namespace utf8
+
+UNIVALUE_TARGET("avx2")
+inline __m256i Utf8TableAvx2(const uint8_t (&table)[16]) noexcept
+{
+    const __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i *>(table));
+    return _mm256_broadcastsi128_si256(t);
+}
+
+/// Returns the 32 bytes ending `N` bytes before the end of `input` (i.e. `input` shifted "right" by N bytes, with
+/// the N trailing bytes of `prev` shifted in).
+template <int N>
+UNIVALUE_TARGET("avx2")
+inline __m256i PrevAvx2(__m256i input, __m256i prev) noexcept
+{
+    return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev, input, 0x21), 16 - N);
+}
+
+struct Utf8CheckerAvx2 {
+    __m256i error, prevInput, prevIncomplete;
+
+    UNIVALUE_TARGET("avx2")
+    void checkBlock(const __m256i input) noexcept
+    {
+        if (!_mm256_movemask_epi8(input)) {
+            // all ASCII: only an error if the previous block ended mid-sequence
+            error = _mm256_or_si256(error, prevIncomplete);
+        } else {
+            const __m256i nibble = _mm256_set1_epi8(0x0f);
+            const __m256i prev1 = PrevAvx2<1>(input, prevInput);
+            const __m256i specialCases = _mm256_and_si256(
+                _mm256_and_si256(_mm256_shuffle_epi8(Utf8TableAvx2(utf8::byte1High),
+                                                     _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+                                 _mm256_shuffle_epi8(Utf8TableAvx2(utf8::byte1Low), _mm256_and_si256(prev1, nibble))),
+                _mm256_shuffle_epi8(Utf8TableAvx2(utf8::byte2High),
+                                    _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble)));
+            // Only 111_____ will be >= 0x80 after the subtraction below, ditto for 1111____ in the 2nd term
+            const __m256i isThirdByte = _mm256_subs_epu8(PrevAvx2<2>(input, prevInput),
+                                                         _mm256_set1_epi8(char(0xe0 - 0x80)));
+            const __m256i isFourthByte = _mm256_subs_epu8(PrevAvx2<3>(input, prevInput),
+                                                          _mm256_set1_epi8(char(0xf0 - 0x80)));
+            const __m256i must23 = _mm256_and_si256(_mm256_or_si256(isThirdByte, isFourthByte),
+                                                    _mm256_set1_epi8(char(0x80)));
+            error = _mm256_or_si256(error, _mm256_xor_si256(must23, specialCases));
+            // A block is "incomplete" if it ends in the middle of a multi-byte sequence, i.e. if any of its last 3
+            // bytes is a lead byte requiring more bytes than the block has left.
+            const __m256i maxValue = _mm256_setr_epi8(
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                -1, -1, -1, -1, char(0xf0 - 1), char(0xe0 - 1), char(0xc0 - 1));
+            prevIncomplete = _mm256_subs_epu8(input, maxValue);
+        }
+        prevInput = input;
+    }
+};
+
+UNIVALUE_TARGET("avx2")
+bool ValidUtf8Avx2(const char *p, const char *end) noexcept
+{
+    Utf8CheckerAvx2 checker{_mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256()};
+    for (; end - p >= 32; p += 32)
+        checker.checkBlock(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)));
+    if (p < end) {
+        // Process the tail as a final block padded with (ASCII) NULs
+        alignas(32) char buf[32] = {};
+        std::memcpy(buf, p, static_cast<size_t>(end - p));
+        checker.checkBlock(_mm256_load_si256(reinterpret_cast<const __m256i *>(buf)));
+    }
+    const __m256i error = _mm256_or_si256(checker.error, checker.prevIncomplete);
+    return _mm256_testz_si256(error, error);
+}
+
+UNIVALUE_TARGET("avx2")
+void Classify64Avx2(const char *p, BlockClasses &out) noexcept
+{
+    out = {};
+    for (unsigned i = 0; i < 64; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+        // '{' | 0x20 == '{', '[' | 0x20 == '{', and likewise for '}' and ']'
+        const __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        const __m256i op = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(lower, _mm256_set1_epi8('{')),
+                                                           _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('}'))),
+                                           _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')),
+                                                           _mm256_cmpeq_epi8(v, _mm256_set1_epi8(','))));
+        const __m256i space = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x20)),
+                                                              _mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x09))),
+                                              _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x0a)),
+                                                              _mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x0d))));
+        out.backslash |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))))) << i;
+        out.quote |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))))) << i;
+        out.space |= uint64_t(uint32_t(_mm256_movemask_epi8(space))) << i;
+        out.op |= uint64_t(uint32_t(_mm256_movemask_epi8(op))) << i;
+    }
+}
+
+constexpr SimdKernels avx2Kernels = {
+    "avx2", FindStringSpecialAvx2, FindStringEndAvx2, SkipWhitespaceAvx2, FindEscapeCharAvx2, ValidUtf8Avx2,
+    Classify64Avx2,
+};
+
+// --- AVX-512 (BW) kernels ---
+
+#define UNIVALUE_TARGET_AVX512 UNIVALUE_TARGET("avx512f,avx512bw")
+
+UNIVALUE_TARGET_AVX512 UNIVALUE_NO_SANITIZE_ADDRESS
+inline uint64_t StringSpecialMaskAvx512(const char *block) noexcept
+{
+    const __m512i v = _mm512_load_si512(block);
+    return _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('"')) | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\\'))
+           | _mm512_cmplt_epi8_mask(v, _mm512_set1_epi8(0x20));
+}
+
+UNIVALUE_TARGET_AVX512 UNIVALUE_NO_SANITIZE_ADDRESS
+inline uint64_t StringEndMaskAvx512(const char *block) noexcept
+{
+    const __m512i v = _mm512_load_si512(block);
+    return _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('"')) | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\\'))
+           | _mm512_cmplt_epu8_mask(v, _mm512_set1_epi8(0x20));
+}
+
+UNIVALUE_TARGET_AVX512 UNIVALUE_NO_SANITIZE_ADDRESS
+inline uint64_t NonSpaceMaskAvx512(const char *block) noexcept
+{
+    const __m512i v = _mm512_load_si512(block);
+    return ~(_mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(0x20)) | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(0x09))
+             | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(0x0a)) | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(0x0d)));
+}
+
+UNIVALUE_TARGET_AVX512
+inline uint64_t EscapeMaskAvx512(__m512i v) noexcept
+{
+    return _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('"')) | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\\'))
+           | _mm512_cmplt_epu8_mask(v, _mm512_set1_epi8(0x20)) | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(0x7f));
+}
+
+UNIVALUE_TARGET_AVX512 UNIVALUE_NO_SANITIZE_ADDRESS
+const char *FindStringSpecialAvx512(const char *p, const char *end) noexcept
+{
+    if (p >= end)
+        return end;
+    const size_t misalign = reinterpret_cast<uintptr_t>(p) & 63u;
+    const char *block = p - misalign;
+    uint64_t mask = StringSpecialMaskAvx512(block) >> misalign;
+    while (!mask) {
+        block += 64;
+        if (block >= end)
+            return end;
+        p = block;
+        mask = StringSpecialMaskAvx512(block);
+    }
+    return std::min(p + CountTrailingZeros(mask), end);
+}
+
+UNIVALUE_TARGET_AVX512 UNIVALUE_NO_SANITIZE_ADDRESS
+const char *FindStringEndAvx512(const char *p, const char *end) noexcept
+{
+    if (p >= end)
+        return end;
+    const size_t misalign = reinterpret_cast<uintptr_t>(p) & 63u;
+    const char *block = p - misalign;
+    uint64_t mask = StringEndMaskAvx512(block) >> misalign;
+    while (!mask) {
+        block += 64;
+        if (block >= end)
+            return end;
+        p = block;
+        mask = StringEndMaskAvx512(block);
+    }
+    return std::min(p + CountTrailingZeros(mask), end);
+}
+
+UNIVALUE_TARGET_AVX512 UNIVALUE_NO_SANITIZE_ADDRESS
+const char *SkipWhitespaceAvx512(const char *p, const char *end) noexcept
+{
+    if (p >= end)
+        return end;
+    const size_t misalign = reinterpret_cast<uintptr_t>(p) & 63u;
+    const char *block = p - misalign;
+    uint64_t mask = NonSpaceMaskAvx512(block) >> misalign;
+    while (!mask) {
+        block += 64;
+        if (block >= end)
+            return end;
+        p = block;
+        mask = NonSpaceMaskAvx512(block);
+    }
+    return std::min(p + CountTrailingZeros(mask), end);
+}
+
+UNIVALUE_TARGET_AVX512
+const char *FindEscapeCharAvx512(const char *p, const char *end) noexcept
+{
+    for (; end - p >= 64; p += 64)
+        if (const uint64_t mask = EscapeMaskAvx512(_mm512_loadu_si512(p)))
+            return p + CountTrailingZeros(mask);
+    if (p < end) {
+        // masked load of the tail, which never touches memory past `end`
+        const __mmask64 tail = ~uint64_t{0} >> (64u - static_cast<unsigned>(end - p));
+        if (const uint64_t mask = EscapeMaskAvx512(_mm512_maskz_loadu_epi8(tail, p)) & tail)
+            return p + CountTrailingZeros(mask);
+    }
+    return end;
+}
+
+UNIVALUE_TARGET_AVX512
+void Classify64Avx512(const char *p, BlockClasses &out) noexcept
+{
+    const __m512i v = _mm512_loadu_si512(p);
+    // '{' | 0x20 == '{', '[' | 0x20 == '{', and likewise for '}' and ']'
+    const __m512i lower = _mm512_or_si512(v, _mm512_set1_epi8(0x20));
+    out.backslash = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\\'));
+    out.quote = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('"'));
+    out.space = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(0x20)) | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(0x09))
+                | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(0x0a)) | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(0x0d));
+    out.op = _mm512_cmpeq_epi8_mask(lower, _mm512_set1_epi8('{')) | _mm512_cmpeq_epi8_mask(lower, _mm512_set1_epi8('}'))
+             | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(':')) | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(','));
+}
+
+#undef UNIVALUE_TARGET_AVX512
+
+constexpr SimdKernels avx512Kernels = {
+    // AVX-512BW implies AVX2, whose UTF-8 validator is used here as well
+    "avx512", FindStringSpecialAvx512, FindStringEndAvx512, SkipWhitespaceAvx512, FindEscapeCharAvx512,
+    ValidUtf8Avx2, Classify64Avx512,
+};
+
+struct X86Features {
+    bool sse2 = false, avx2 = false, avx512bw = false;
+};
+
+X86Features DetectX86Features() noexcept
+{
+    const auto cpuid = [](uint32_t leaf, uint32_t subleaf, uint32_t (&regs)[4]) {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int r[4];
+        __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+        for (int i = 0; i < 4; ++i) regs[i] = static_cast<uint32_t>(r[i]);
+#else
+        __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    };
+    const auto xgetbv = []() -> uint64_t {
+#if defined(_MSC_VER) && !defined(__clang__)
+        return _xgetbv(0);
+#else
+        uint32_t eax, edx;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (uint64_t{edx} << 32) | eax;
+#endif
+    };
+    X86Features ret;
+    uint32_t regs[4]; // eax, ebx, ecx, edx
+    cpuid(0, 0, regs);
+    const uint32_t maxLeaf = regs[0];
+    if (maxLeaf < 1)
+        return ret;
+    cpuid(1, 0, regs);
+    ret.sse2 = regs[3] & (1u << 26);
+    const bool osxsave = regs[2] & (1u << 27), avx = regs[2] & (1u << 28);
+    if (!osxsave || !avx || maxLeaf < 7)
+        return ret;
+    // Ensure the OS saves the YMM (and for AVX-512: opmask and ZMM) register state on context switches
+    const uint64_t xcr0 = xgetbv();
+    const bool ymmState = (xcr0 & 0x6) == 0x6, zmmState = (xcr0 & 0xe6) == 0xe6;
+    cpuid(7, 0, regs);
+    ret.avx2 = ymmState && (regs[1] & (1u << 5));
+    ret.avx512bw = zmmState && ret.avx2 && (regs[1] & (1u << 16)) && (regs[1] & (1u << 30));
+    return ret;
+}
+
+#elif defined(UNIVALUE_SIMD_NEON)
+
+// --- NEON kernels ---
+
+// Returns a 64-bit mask with 4 bits set for every byte set in the comparison result `m`.
+inline uint64_t NeonMask(uint8x16_t m) noexcept
+{
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+}
+
+UNIVALUE_NO_SANITIZE_ADDRESS
+inline uint64_t StringSpecialMaskNeon(const char *block) noexcept
+{
+    const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(block));
+    return NeonMask(vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8('"')), vceqq_u8(v, vdupq_n_u8('\\'))),
+                             vcltq_s8(vreinterpretq_s8_u8(v), vdupq_n_s8(0x20))));
+}
+
+UNIVALUE_NO_SANITIZE_ADDRESS
+inline uint64_t StringEndMaskNeon(const char *block) noexcept
+{
+    const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(block));
+    return NeonMask(vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8('"')), vceqq_u8(v, vdupq_n_u8('\\'))),
+                             vcltq_u8(v, vdupq_n_u8(0x20))));
+}
+
+UNIVALUE_NO_SANITIZE_ADDRESS
+inline uint64_t NonSpaceMaskNeon(const char *block) noexcept
+{
+    const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(block));
+    return ~NeonMask(vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8(0x20)), vceqq_u8(v, vdupq_n_u8(0x09))),
+                              vorrq_u8(vceqq_u8(v, vdupq_n_u8(0x0a)), vceqq_u8(v, vdupq_n_u8(0x0d)))));
+}
+
+UNIVALUE_NO_SANITIZE_ADDRESS
+const char *FindStringSpecialNeon(const char *p, const char *end) noexcept
+{
+    if (p >= end)
+        return end;
+    const size_t misalign = reinterpret_cast<uintptr_t>(p) & 15u;
+    const char *block = p - misalign;
+    uint64_t mask = StringSpecialMaskNeon(block) >> (misalign * 4u);
+    while (!mask) {
+        block += 16;
+        if (block >= end)
+            return end;
+        p = block;
+        mask = StringSpecialMaskNeon(block);
+    }
+    return std::min(p + (CountTrailingZeros(mask) >> 2), end);
+}
+
+UNIVALUE_NO_SANITIZE_ADDRESS
+const char *FindStringEndNeon(const char *p, const char *end) noexcept
+{
+    if (p >= end)
+        return end;
+    const size_t misalign = reinterpret_cast<uintptr_t>(p) & 15u;
+    const char *block = p - misalign;
+    uint64_t mask = StringEndMaskNeon(block) >> (misalign * 4u);
+    while (!mask) {
+        block += 16;
+        if (block >= end)
+            return end;
+        p = block;
+        mask = StringEndMaskNeon(block);
+    }
+    return std::min(p + (CountTrailingZeros(mask) >> 2), end);
+}
+
+UNIVALUE_NO_SANITIZE_ADDRESS
+const char *SkipWhitespaceNeon(const char *p, const char *end) noexcept
+{
+    if (p >= end)
+        return end;
+    const size_t misalign = reinterpret_cast<uintptr_t>(p) & 15u;
+    const char *block = p - misalign;
+    uint64_t mask = NonSpaceMaskNeon(block) >> (misalign * 4u);
+    while (!mask) {
+        block += 16;
+        if (block >= end)
+            return end;
+        p = block;
+        mask = NonSpaceMaskNeon(block);
+    }
+    return std::min(p + (CountTrailingZeros(mask) >> 2), end);
+}
+
+const char *FindEscapeCharNeon(const char *p, const char *end) noexcept
+{
+    for (; end - p >= 16; p += 16) {
+        const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+        const uint8x16_t m = vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8('"')), vceqq_u8(v, vdupq_n_u8('\\'))),
+                                      vorrq_u8(vcltq_u8(v, vdupq_n_u8(0x20)), vceqq_u8(v, vdupq_n_u8(0x7f))));
+        if (const uint64_t mask = NeonMask(m))
+            return p + (CountTrailingZeros(mask) >> 2);
+    }
+    return FindEscapeCharScalar(p, end);
+}
+
+bool ValidUtf8Neon(const char *p, const char *end) noexcept
+{
+    // Skip ASCII 16 bytes at a time, and validate the multi-byte sequences one at a time
+    auto *up = reinterpret_cast<const uint8_t *>(p), *uend = reinterpret_cast<const uint8_t *>(end);
+    while (up < uend) {
+        if (uend - up >= 16 && vmaxvq_u8(vld1q_u8(up)) < 0x80) {
+            up += 16;
+            continue;
+        }
+        const size_t len = Utf8SequenceLength(up, uend);
+        if (!len)
+            return false;
+        up += len;
+    }
+    return true;
+}
+
+/// Returns a 64-bit mask with bit i set for every byte i set in the 4 comparison results `m0`..`m3`.
+inline uint64_t NeonMask64(uint8x16_t m0, uint8x16_t m1, uint8x16_t m2, uint8x16_t m3) noexcept
+{
+    const uint8x16_t bits = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+                             0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
+    uint8x16_t sum0 = vpaddq_u8(vandq_u8(m0, bits), vandq_u8(m1, bits));
+    const uint8x16_t sum1 = vpaddq_u8(vandq_u8(m2, bits), vandq_u8(m3, bits));
+    sum0 = vpaddq_u8(sum0, sum1);
+    sum0 = vpaddq_u8(sum0, sum0);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(sum0), 0);
+}
+
+void Classify64Neon(const char *p, BlockClasses &out) noexcept
+{
+    uint8x16_t backslash[4], quote[4], space[4], op[4];
+    for (unsigned i = 0; i < 4; ++i) {
+        const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(p) + 16 * i);
+        // '{' | 0x20 == '{', '[' | 0x20 == '{', and likewise for '}' and ']'
+        const uint8x16_t lower = vorrq_u8(v, vdupq_n_u8(0x20));
+        backslash[i] = vceqq_u8(v, vdupq_n_u8('\\'));
+        quote[i] = vceqq_u8(v, vdupq_n_u8('"'));
+        space[i] = vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8(0x20)), vceqq_u8(v, vdupq_n_u8(0x09))),
+                            vorrq_u8(vceqq_u8(v, vdupq_n_u8(0x0a)), vceqq_u8(v, vdupq_n_u8(0x0d))));
+        op[i] = vorrq_u8(vorrq_u8(vceqq_u8(lower, vdupq_n_u8('{')), vceqq_u8(lower, vdupq_n_u8('}'))),
+                         vorrq_u8(vceqq_u8(v, vdupq_n_u8(':')), vceqq_u8(v, vdupq_n_u8(','))));
+    }
+    out.backslash = NeonMask64(backslash[0], backslash[1], backslash[2], backslash[3]);
+    out.quote = NeonMask64(quote[0], quote[1], quote[2], quote[3]);
+    out.space = NeonMask64(space[0], space[1], space[2], space[3]);
+    out.op = NeonMask64(op[0], op[1], op[2], op[3]);
+}
+
+constexpr SimdKernels neonKernels = {
+    "neon", FindStringSpecialNeon, FindStringEndNeon, SkipWhitespaceNeon, FindEscapeCharNeon, ValidUtf8Neon,
+    Classify64Neon,
+};
+
+#endif
+
+/// Returns all the implementations supported by this CPU, best first.
+const std::vector<const SimdKernels *> &SupportedKernels()
+{
+    static const std::vector<const SimdKernels *> supported = [] {
+        std::vector<const SimdKernels *> ret;
+#if defined(UNIVALUE_SIMD_X86)
+        const X86Features features = DetectX86Features();
+        if (features.avx512bw) ret.push_back(&avx512Kernels);
+        if (features.avx2) ret.push_back(&avx2Kernels);
+        if (features.sse2) ret.push_back(&sse2Kernels);
+#elif defined(UNIVALUE_SIMD_NEON)
+        ret.push_back(&neonKernels);
+#endif
+        ret.push_back(&scalarKernels);
+        return ret;
+    }();
+    return supported;
+}
+
+std::atomic<const SimdKernels *> activeKernels{nullptr};
+
+} // namespace
+
+const SimdKernels &simd() noexcept
+{
+    if (const SimdKernels *k = activeKernels.load(std::memory_order_relaxed))
+        return *k;
+    // First time through: select the best implementation. Note that the tables are all constant-initialized, so a
+    // relaxed load suffices above.
+    const SimdKernels *expected = nullptr;
+    activeKernels.compare_exchange_strong(expected, SupportedKernels().front(), std::memory_order_relaxed);
+    return *activeKernels.load(std::memory_order_relaxed);
+}
+
+namespace {
+
+/// Returns `x` with bit i set iff an odd number of the bits 0..i are set in `x`.
+inline uint64_t PrefixXor(uint64_t x) noexcept
+{
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+/// Returns the mask of the characters that are escaped by a preceding backslash, given the mask of backslashes.
+/// In a run of backslashes every 2nd one is escaped, as is the character after a run of odd length. `prevEscaped`
+/// carries the state across blocks (it is 1 if the first character of the next block is escaped).
+inline uint64_t FindEscaped(uint64_t backslash, uint64_t &prevEscaped) noexcept
+{
+    constexpr uint64_t evenBits = 0x5555555555555555u;
+    backslash &= ~prevEscaped;
+    const uint64_t followsEscape = backslash << 1 | prevEscaped;
+    // Adding the starts of the runs which begin on odd bits to the runs themselves clears those runs (carrying
+    // out of their ends), which lets us flip the parity of the escaped characters for them below.
+    const uint64_t oddSequenceStarts = backslash & ~evenBits & ~followsEscape;
+    const uint64_t sequencesStartingOnEvenBits = oddSequenceStarts + backslash;
+    prevEscaped = sequencesStartingOnEvenBits < oddSequenceStarts; // overflow
+    const uint64_t invertMask = sequencesStartingOnEvenBits << 1;
+    return (evenBits ^ invertMask) & followsEscape;
+}
+
+/// Tracks the strings across the consecutive 64-byte blocks of the input.
+struct StringTracker {
+    uint64_t prevEscaped = 0, prevInString = 0;
+
+    /// Returns the mask of the characters of the block with classes `c` that lie within strings, from their opening
+    /// quote up to (but not including) their closing quote. Sets `quote` to the mask of the unescaped quotes.
+    uint64_t next(const BlockClasses &c, uint64_t &quote) noexcept {
+        quote = c.quote & ~FindEscaped(c.backslash, prevEscaped);
+        const uint64_t inString = PrefixXor(quote) ^ prevInString;
+        prevInString = uint64_t{0} - (inString >> 63);
+        return inString;
+    }
+};
+
+/// Calls `func(block, offset)` for each 64-byte block of the `len` bytes at `p`, in order, until it returns false. The
+/// last block is padded with whitespace, which is neutral. Returns false if `func` did.
+template <typename Func>
+bool ForEachBlock(const char *p, size_t len, Func &&func)
+{
+    size_t offset = 0;
+    for (; len - offset >= 64; offset += 64)
+        if (!func(p + offset, uint32_t(offset)))
+            return false;
+    if (offset < len) {
+        char block[64];
+        std::memset(block, ' ', sizeof(block));
+        std::memcpy(block, p + offset, len - offset);
+        return func(static_cast<const char *>(block), uint32_t(offset));
+    }
+    return true;
+}
+
+
+} // namespace
+
+bool BuildStructuralIndex(const char *p, size_t len, StructuralIndex &out)
+{
+    if (len >= std::numeric_limits<uint32_t>::max())
+        return false;
+    const auto classify64 = simd().classify64;
+    out.size = 0;
+    if (!out.capacity) {
+        // A generous first guess: real-world JSON has well under 1 structural character per 4 bytes
+        out.capacity = len / 4 + 64;
+        out.positions.reset(new uint32_t[out.capacity]);
+    }
+
+    StringTracker strings;
+    uint64_t prevScalar = 0;
+    ForEachBlock(p, len, [&](const char *block, uint32_t offset) {
+        BlockClasses c;
+        classify64(block, c);
+        uint64_t quote;
+        const uint64_t inString = strings.next(c, quote);
+        const uint64_t stringOrQuote = inString | quote;
+        // Numbers and literals are runs of anything else, outside of strings
+        const uint64_t scalar = ~(c.space | c.op | stringOrQuote);
+        const uint64_t scalarStart = scalar & ~(scalar << 1 | prevScalar);
+        prevScalar = scalar >> 63;
+        uint64_t structurals = (c.op & ~stringOrQuote) | (quote & inString) | scalarStart;
+
+        if (out.capacity - out.size < 64) {
+            const size_t newCapacity = out.capacity * 2 + 64;
+            std::unique_ptr<uint32_t[]> positions(new uint32_t[newCapacity]);
+            std::memcpy(positions.get(), out.positions.get(), out.size * sizeof(uint32_t));
+            out.positions = std::move(positions);
+            out.capacity = newCapacity;
+        }
+        uint32_t * const positions = out.positions.get();
+        while (structurals) {
+            positions[out.size++] = offset + CountTrailingZeros(structurals);
+            structurals &= structurals - 1;
+        }
+        return true;
+    });
+    return !strings.prevInString;
+}
+
+bool FindTopLevelSeparators(const char *p, size_t len, std::vector<uint32_t> &separators)
+{
+    if (len >= std::numeric_limits<uint32_t>::max())
+        return false;
+    const auto classify64 = simd().classify64;
+    StringTracker strings;
+    size_t depth = 0;
+    bool closed = false;
+    ForEachBlock(p, len, [&](const char *block, uint32_t offset) {
+        BlockClasses c;
+        classify64(block, c);
+        uint64_t quote;
+        // Only the structural characters outside of strings matter here, and only those at depth 1 are kept
+        for (uint64_t ops = c.op & ~(strings.next(c, quote) | quote); ops; ops &= ops - 1) {
+            const unsigned i = CountTrailingZeros(ops);
+            switch (block[i]) {
+            case '{':
+            case '[':
+                if (++depth == 1)
+                    separators.push_back(offset + i);
+                break;
+            case '}':
+            case ']':
+                if (depth == 0)
+                    return false;
+                if (--depth == 0) {
+                    separators.push_back(offset + i);
+                    // The root must be closed by the matching bracket
+                    closed = block[i] == (p[separators.front()] == '{' ? '}' : ']');
+                    return false;
+                }
+                break;
+            default: // ',' or ':'
+                if (depth == 0)
+                    return false;
+                if (depth == 1 && block[i] == ',')
+                    separators.push_back(offset + i);
+                break;
+            }
+        }
+        return true;
+    });
+    return closed;
+}
+
+} // namespace univalue_internal
+
+/* static */
+const char *UniValue::simdImplementation() noexcept { return univalue_internal::simd().name; }
+
+/* static */
+std::vector<std::string> UniValue::simdImplementations()
+{
+    std::vector<std::string> ret;
+    for (const auto *k : univalue_internal::SupportedKernels())
+        ret.emplace_back(k->name);
+    return ret;
+}
+
+/* static */
+bool UniValue::setSimdImplementation(std::string_view name)
+{
+    for (const auto *k : univalue_internal::SupportedKernels()) {
+        if (name == k->name) {
+            univalue_internal::activeKernels.store(k, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
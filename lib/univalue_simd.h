@@ -0,0 +1,79 @@
+// Copyright (c) 2026 Calin A. Culianu <calin.culianu@gmail.com>
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace univalue_internal {
+
+/// Per-byte classification of a 64-byte block of JSON: bit i of each mask describes byte i of the block.
+struct BlockClasses {
+    uint64_t backslash; ///< '\\'
+    uint64_t quote; ///< '"'
+    uint64_t space; ///< JSON whitespace: ' ', '\t', '\n', '\r'
+    uint64_t op; ///< The structural characters: '{', '}', '[', ']', ':', ','
+};
+
+/**
+ * Table of the hot-path kernels used by the parser and the serializer.
+ *
+ * Several implementations of each kernel exist (scalar, SSE2, AVX2, AVX-512, NEON). The best set supported by the
+ * CPU we are running on is selected once at runtime, so that the library need not be compiled with -march=native.
+ *
+ * The scanning kernels may read (but never act on) bytes outside of [p, end), as long as they are within an aligned
+ * block that overlaps [p, end). Aligned loads never cross a page boundary, so this is always safe, and the input
+ * needs neither NUL-termination nor padding.
+ */
+struct SimdKernels {
+    const char *name;
+
+    /// Returns a pointer to the first '"', '\\', control character (< 0x20) or non-ASCII byte (>= 0x80) in [p, end),
+    /// or `end` if there are none.
+    const char *(*findStringSpecial)(const char *p, const char *end) noexcept;
+
+    /// Returns a pointer to the first '"', '\\' or control character in [p, end), or `end` if there are none.
+    const char *(*findStringEnd)(const char *p, const char *end) noexcept;
+
+    /// Returns a pointer to the first non-whitespace character in [p, end), or `end` if there are none.
+    const char *(*skipWhitespace)(const char *p, const char *end) noexcept;
+
+    /// Returns a pointer to the first character in [p, end) that must be escaped when serialized as part of a JSON
+    /// string (control characters, '"', '\\' and DEL), or `end` if there are none.
+    const char *(*findEscapeChar)(const char *p, const char *end) noexcept;
+
+    /// Returns true if [p, end) is entirely well-formed UTF-8 as per RFC 3629 (no overlong forms, no surrogates, no
+    /// codepoints above U+10FFFF, no truncated sequences).
+    bool (*validUtf8)(const char *p, const char *end) noexcept;
+
+    /// Classifies the 64 bytes at `p` (which need not be aligned, but must all be readable).
+    void (*classify64)(const char *p, BlockClasses &out) noexcept;
+};
+
+/// Returns the kernels in use. This is the best implementation for this CPU, unless overridden by
+/// UniValue::setSimdImplementation().
+const SimdKernels &simd() noexcept;
+
+/// The output of stage 1 of the structural index read engine: the offsets into the input of every structural
+/// character outside of strings, of every opening '"', and of the first character of every other token (numbers and
+/// literals), in order.
+struct StructuralIndex {
+    std::unique_ptr<uint32_t[]> positions;
+    size_t size = 0, capacity = 0;
+};
+
+/// Builds the structural index of the `len` bytes at `p`. Returns false if the input ends inside a string, or is too
+/// large (4 GiB or more) to be indexed. Other errors are not detected here, but later in stage 2.
+bool BuildStructuralIndex(const char *p, size_t len, StructuralIndex &out);
+
+/// Finds the top-level structure of the object or array at the start of the `len` bytes at `p`, without indexing the
+/// rest: appends to `separators` the offsets of its opening bracket, of each comma directly within it, and of its
+/// closing bracket. Nothing after the closing bracket is looked at. Returns false if no object or array comes first,
+/// if the root is closed by the wrong bracket or never closed, or if the input is 4 GiB or more.
+bool FindTopLevelSeparators(const char *p, size_t len, std::vector<uint32_t> &separators);
+
+} // namespace univalue_internal
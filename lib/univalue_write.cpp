@@ -5,9 +5,17 @@
 // file COPYING or https://opensource.org/licenses/mit-license.php.
 
 #include "univalue.h"
+#include "univalue_simd.h"
 
+#include <algorithm>
 #include <array>
+#include <cassert>
 #include <cstring>
+#include <functional>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace {
 const std::array<const char *, 256> escapes = {{
@@ -273,13 +281,18 @@ const std::array<const char *, 256> escapes = {{
 /* static */
 void UniValue::jsonEscape(Stream & ss, std::string_view inS)
 {
-    for (const auto ch : inS) {
-        const char * const escStr = escapes[uint8_t(ch)];
-
-        if (escStr)
-            ss << escStr;
-        else
-            ss.put(ch);
+    const auto findEscapeChar = univalue_internal::simd().findEscapeChar;
+    const char *p = inS.data(), * const end = p + inS.size();
+    while (p < end) {
+        // append the run of characters that need no escaping in bulk
+        const char * const esc = findEscapeChar(p, end);
+        ss << std::string_view(p, esc - p);
+        if (esc == end)
+            break;
+        const char * const escStr = escapes[uint8_t(*esc)];
+        assert(escStr);
+        ss << escStr;
+        p = esc + 1;
     }
 }
 
@@ -311,9 +324,11 @@ void UniValue::stringify(Stream& ss, const UniValue& value, const unsigned int p
     case VARR:
         stringify(ss, value.var.get<Array>(), prettyIndent, indentLevel);
         break;
-    case VNUM:
-        ss << value.var.get<NumStr>();
+    case VNUM: {
+        char buf[NumBin::maxTextLen];
+        ss << value.numText(buf);
         break;
+    }
     case VSTR:
         stringify(ss, value.var.get<std::string>(), prettyIndent, indentLevel);
         break;
@@ -372,3 +387,47 @@ void UniValue::stringify(Stream& ss, std::string_view string,
     jsonEscape(ss, string);
     ss.put('"');
 }
+
+/* static */
+std::string UniValue::writeLines(const UniValue *values, const size_t count, unsigned threads)
+{
+    // By default, each thread gets at least this many values, so that the threads are worth their overhead
+    constexpr size_t minValuesPerThread = 64;
+
+    if (!threads)
+        threads = std::min<size_t>(std::thread::hardware_concurrency(), count / minValuesPerThread);
+    threads = std::max<size_t>(std::min<size_t>(threads, count), 1);
+
+    // Stringifies values [first, last) to `s`, one per line
+    const auto writeRun = [values](size_t first, size_t last, std::string &s) {
+        Stream ss{s};
+        for (size_t i = first; i < last; ++i) {
+            stringify(ss, values[i], 0, 0);
+            ss.put('\n');
+        }
+    };
+
+    // Each run but the last is stringified on a thread of its own, and then appended to the output of the last
+    std::vector<std::string> runs(threads - 1);
+    std::vector<std::future<void>> results;
+    results.reserve(threads - 1);
+    for (unsigned t = 0; t + 1 < threads; ++t)
+        results.push_back(std::async(std::launch::async, writeRun, count * t / threads, count * (t + 1) / threads,
+                                     std::ref(runs[t])));
+    std::string last;
+    writeRun(count * (threads - 1) / threads, count, last);
+    if (runs.empty())
+        return last;
+
+    size_t size = last.size();
+    for (unsigned t = 0; t + 1 < threads; ++t) {
+        results[t].get();
+        size += runs[t].size();
+    }
+    std::string out;
+    out.reserve(size);
+    for (const auto &run : runs)
+        out += run;
+    out += last;
+    return out;
+}
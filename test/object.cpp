@@ -10,15 +10,24 @@
 
 #include "univalue.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <clocale>
 #include <cmath>
 #include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <future>
 #include <iostream>
 #include <limits>
 #include <locale>
+#include <memory_resource>
+#include <new>
 #include <stdexcept>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #define BOOST_FIXTURE_TEST_SUITE(a, b)
@@ -55,6 +64,40 @@
 	} \
 } while(0)
 
+// Counts the allocations made with the global operator new, and their bytes, for the tests of what allocates memory
+static std::atomic<size_t> g_allocations{0}, g_allocatedBytes{0};
+void *operator new(std::size_t size)
+{
+    ++g_allocations;
+    g_allocatedBytes += size;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void *operator new[](std::size_t size) { return operator new(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    ++g_allocations;
+    g_allocatedBytes += size;
+    return std::malloc(size ? size : 1);
+}
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept { return operator new(size, tag); }
+// Once the standard allocators are inlined, GCC sees memory from operator new reaching free() here, and warns of a
+// mismatch; but every operator new above allocates with malloc(), so each of these deletes does match.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { std::free(p); }
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
 BOOST_FIXTURE_TEST_SUITE(univalue_tests, BasicTestingSetup)
 
 BOOST_AUTO_TEST_CASE(univalue_constructor)
@@ -863,6 +906,20 @@ BOOST_AUTO_TEST_CASE(univalue_readwrite)
     BOOST_CHECK(!v.read("{}[]"));
     BOOST_CHECK(!v.read("{} 42"));
 
+    // Length-delimited reads: nothing past the end of the buffer is parsed, and embedded NULs are rejected
+    const char *errpos = nullptr;
+    const std::string_view digits = "1234";
+    BOOST_CHECK(v.read(digits.data(), 2, &errpos) == digits.data() + 2 && !errpos);
+    BOOST_CHECK_EQUAL(v.getValStr(), "12");
+    BOOST_CHECK(v.read(std::string_view("truex").substr(0, 4)));
+    BOOST_CHECK(v.isTrue());
+    BOOST_CHECK(!v.read(digits.data(), 0, &errpos) && errpos == digits.data());
+    std::string_view::size_type pos{};
+    BOOST_CHECK(!v.read(std::string_view("\"abc\"", 4), &pos) && pos == 4);
+    BOOST_CHECK(!v.read(std::string_view("[1]\0", 4), &pos) && pos == 3);
+    BOOST_CHECK(!v.read(std::string_view("[\"a\0\"]", 6), &pos) && pos == 3);
+    BOOST_CHECK(!v.read(std::string_view{}, &pos) && pos == 0);
+
     // check that json escapes work correctly by putting a json string INTO a UniValue
     // and doing a round of ser/deser on it.
     v.setArray();
@@ -882,6 +939,1140 @@ BOOST_AUTO_TEST_CASE(univalue_readwrite)
     BOOST_CHECK_EQUAL(v, vjson1); // ensure it deserializes to equal
 }
 
+BOOST_AUTO_TEST_CASE(univalue_document)
+{
+    UniValue expected;
+    BOOST_CHECK(expected.read(json1));
+
+    UniValue::Document doc;
+    BOOST_CHECK(doc->isNull());
+    BOOST_CHECK(doc.read(json1));
+    BOOST_CHECK_EQUAL(doc.root(), expected);
+    BOOST_CHECK_EQUAL(UniValue::stringify(*doc), UniValue::stringify(expected));
+
+    // copies are independent of the arena
+    const UniValue copy(doc.root());
+    doc.clear();
+    BOOST_CHECK(doc->isNull());
+    BOOST_CHECK_EQUAL(copy, expected);
+
+    // re-reading releases the previous value, and the document may be modified like any other value
+    for (int i = 0; i < 3; ++i) {
+        BOOST_CHECK(doc.read(std::string_view{"{\"a\": [1, 2, {\"b\": null}]}"}));
+        BOOST_CHECK_EQUAL(doc->size(), 1);
+        doc->get_obj().at("a").get_array().emplace_back("a string that is too long for the small string buffer");
+        BOOST_CHECK_EQUAL(UniValue::stringify(*doc),
+                          "{\"a\":[1,2,{\"b\":null},\"a string that is too long for the small string buffer\"]}");
+    }
+
+    // errors are reported just like UniValue::read()
+    std::string_view::size_type errpos{};
+    BOOST_CHECK(!doc.read(std::string_view{"[1, 2,]"}, &errpos));
+    BOOST_CHECK_EQUAL(errpos, 7);
+    BOOST_CHECK(!doc.read(std::string_view{"[1, 2,]"}, &errpos, UniValue::ReadEngine::StructuralIndex));
+    BOOST_CHECK_EQUAL(errpos, 7);
+    BOOST_CHECK(doc.read(std::string_view{"[1, 2]"}, &errpos, UniValue::ReadEngine::StructuralIndex));
+    BOOST_CHECK_EQUAL(errpos, std::string_view::npos);
+
+    // objects and arrays allocate from the memory resource they were given
+    struct CountingResource : std::pmr::memory_resource {
+        size_t allocs = 0, deallocs = 0;
+        void *do_allocate(size_t bytes, size_t align) override {
+            ++allocs;
+            return std::pmr::new_delete_resource()->allocate(bytes, align);
+        }
+        void do_deallocate(void *p, size_t bytes, size_t align) override {
+            ++deallocs;
+            std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+        }
+        bool do_is_equal(const std::pmr::memory_resource &o) const noexcept override { return this == &o; }
+    } res;
+    {
+        UniValue::Array arr(&res);
+        for (int i = 0; i < 10; ++i)
+            arr.push_back(i);
+        BOOST_CHECK(res.allocs > 0);
+        UniValue v(std::move(arr)); // moves keep the resource
+        const size_t allocs = res.allocs;
+        v.get_array().push_back(10);
+        v.get_array().push_back(11);
+        v.get_array().push_back(12);
+        v.get_array().push_back(13);
+        v.get_array().push_back(14);
+        v.get_array().push_back(15);
+        v.get_array().push_back(16);
+        BOOST_CHECK(res.allocs > allocs);
+        const UniValue vcopy(v); // copies do not
+        BOOST_CHECK_EQUAL(vcopy, v);
+        BOOST_CHECK_EQUAL(vcopy.size(), 17);
+    }
+    BOOST_CHECK(res.allocs > 0);
+    BOOST_CHECK_EQUAL(res.allocs, res.deallocs);
+}
+
+// Returns true if all objects and arrays within `v` are allocated from `mr`.
+static bool AllocatedFrom(const UniValue &v, const std::pmr::memory_resource *mr)
+{
+    if (v.isObject()) {
+        if (v.resource() != mr)
+            return false;
+        for (const auto &[key, value] : v.get_obj())
+            if (!AllocatedFrom(value, mr))
+                return false;
+    } else if (v.isArray()) {
+        if (v.resource() != mr)
+            return false;
+        for (const auto &value : v.get_array())
+            if (!AllocatedFrom(value, mr))
+                return false;
+    }
+    return true;
+}
+
+BOOST_AUTO_TEST_CASE(univalue_memory_resource)
+{
+    UniValue expected;
+    BOOST_CHECK(expected.read(json1));
+    BOOST_CHECK(AllocatedFrom(expected, nullptr));
+
+    std::pmr::unsynchronized_pool_resource pool;
+    {
+        // read() allocates every object and array from the resource
+        for (const auto engine : {UniValue::ReadEngine::Tokenizer, UniValue::ReadEngine::StructuralIndex}) {
+            UniValue v;
+            BOOST_CHECK(v.read(json1, nullptr, engine, &pool));
+            BOOST_CHECK_EQUAL(v, expected);
+            BOOST_CHECK(v.resource() == &pool);
+            BOOST_CHECK(AllocatedFrom(v, &pool));
+        }
+
+        // builders propagate the resource to inserted values
+        UniValue::Array arr(&pool);
+        arr.push_back(expected); // a copy from the heap
+        arr.emplace_back(UniValue::VOBJ);
+        arr.emplace_back(UniValue::Object{{"a", UniValue::Array{1, 2, UniValue::Array{3}}}});
+        arr.push_back(1);
+        UniValue v(std::move(arr));
+        v.get_array().at(1).get_obj().emplace_back("b", UniValue::Array{4, 5});
+        v.get_array().at(1).get_obj().push_back({"c", UniValue::Object{{"d", UniValue::Array{}}}});
+        BOOST_CHECK(AllocatedFrom(v, &pool));
+        BOOST_CHECK_EQUAL(v[0], expected);
+        BOOST_CHECK_EQUAL(UniValue::stringify(v[1]), R"({"b":[4,5],"c":{"d":[]}})");
+        BOOST_CHECK_EQUAL(UniValue::stringify(v[2]), R"({"a":[1,2,[3]]})");
+
+        // ... but not to containers modified in place, which is what setObject(mr) and setArray(mr) are for
+        v.get_array().at(3).setArray();
+        BOOST_CHECK(!AllocatedFrom(v, &pool));
+        v.get_array().at(3).setArray(&pool);
+        BOOST_CHECK(AllocatedFrom(v, &pool));
+
+        // allocator-extended copy and move
+        const UniValue heapCopy(v, nullptr);
+        BOOST_CHECK_EQUAL(heapCopy, v);
+        BOOST_CHECK(AllocatedFrom(heapCopy, nullptr));
+        UniValue poolCopy(heapCopy, &pool);
+        BOOST_CHECK_EQUAL(poolCopy, v);
+        BOOST_CHECK(AllocatedFrom(poolCopy, &pool));
+        UniValue heapMoved(std::move(poolCopy), nullptr);
+        BOOST_CHECK_EQUAL(heapMoved, v);
+        BOOST_CHECK(AllocatedFrom(heapMoved, nullptr));
+
+        // a container that already uses the resource is moved as-is, but its children are reallocated if needed
+        UniValue mixed(UniValue::VARR);
+        mixed.get_array().push_back(UniValue(v, &pool));
+        BOOST_CHECK(!AllocatedFrom(mixed, nullptr));
+        UniValue fixed(std::move(mixed), nullptr);
+        BOOST_CHECK(AllocatedFrom(fixed, nullptr));
+        BOOST_CHECK_EQUAL(fixed[0], v);
+    }
+
+    // moving a value out of a Document such that it outlives it
+    UniValue outlives;
+    {
+        UniValue::Document doc;
+        BOOST_CHECK(doc.read(std::string_view{json1}));
+        outlives = UniValue(std::move(doc.root()), nullptr);
+    }
+    BOOST_CHECK_EQUAL(outlives, expected);
+    BOOST_CHECK(AllocatedFrom(outlives, nullptr));
+}
+
+BOOST_AUTO_TEST_CASE(univalue_read_in_place)
+{
+    const std::string_view docs[] = {
+        R"({"name": "a string that is too long for the small string buffer", "list": [1, 2, {"x": "y"}], "n": null})",
+        R"({"name": "another string that is too long for the small string buffer", "list": [3, 4, 5, 6], "t": true})",
+        R"({"list": [], "name": 1.5})",
+        R"([{"a": [1, 2]}, "x", {}])",
+        R"("just a string")",
+        R"({"name": "short", "list": [{"x": "z"}, 7], "n": {"deep": [[[]]]}})",
+    };
+    for (const auto engine : {UniValue::ReadEngine::Tokenizer, UniValue::ReadEngine::StructuralIndex}) {
+        // the result is always the same as that of read(), whatever was there before
+        UniValue v;
+        for (const auto a : docs) {
+            for (const auto b : docs) {
+                BOOST_CHECK(v.read(a, nullptr, engine));
+                BOOST_CHECK(v.readInPlace(b, nullptr, engine));
+                UniValue expected;
+                BOOST_CHECK(expected.read(b, nullptr, engine));
+                BOOST_CHECK_EQUAL(v, expected);
+                BOOST_CHECK_EQUAL(UniValue::stringify(v), UniValue::stringify(expected));
+            }
+        }
+
+        // storage is recycled where the types match
+        BOOST_CHECK(v.read(docs[1], nullptr, engine));
+        const char * const name = v["name"].get_str().data();
+        const UniValue * const elems = &v["list"][0];
+        BOOST_CHECK(v.readInPlace(docs[0], nullptr, engine));
+        BOOST_CHECK_EQUAL(v["name"].get_str(), "a string that is too long for the small string buffer");
+        BOOST_CHECK_EQUAL(v["name"].get_str().data(), name);
+        BOOST_CHECK_EQUAL(&v["list"][0], elems);
+        BOOST_CHECK_EQUAL(v["list"].size(), 3);
+        BOOST_CHECK(v.locate("t") == nullptr);
+        BOOST_CHECK(v["n"].isNull());
+
+        // errors are reported just like read()
+        std::string_view::size_type errpos{};
+        BOOST_CHECK(!v.readInPlace(std::string_view{"[1, 2,]"}, &errpos, engine));
+        BOOST_CHECK_EQUAL(errpos, 7);
+        BOOST_CHECK(v.readInPlace(std::string_view{"[1, 2]"}, &errpos, engine));
+        BOOST_CHECK_EQUAL(errpos, std::string_view::npos);
+        BOOST_CHECK_EQUAL(UniValue::stringify(v), "[1,2]");
+    }
+
+    // new objects and arrays are allocated from the memory resource of the value
+    std::pmr::unsynchronized_pool_resource pool;
+    UniValue v;
+    v.setArray(&pool);
+    BOOST_CHECK(v.readInPlace(docs[3]));
+    BOOST_CHECK(AllocatedFrom(v, &pool));
+    BOOST_CHECK(v.readInPlace(docs[0])); // also if the root changes type
+    BOOST_CHECK(AllocatedFrom(v, &pool));
+    v.setNull();
+    BOOST_CHECK(v.readInPlace(docs[0]));
+    BOOST_CHECK(AllocatedFrom(v, nullptr));
+}
+
+BOOST_AUTO_TEST_CASE(univalue_stream_reader)
+{
+    UniValue expected;
+    BOOST_CHECK(expected.read(json1));
+    const std::string_view json{json1};
+
+    // the input may be split anywhere
+    UniValue::StreamReader reader;
+    for (size_t split = 0; split <= json.size(); ++split) {
+        reader.reset();
+        BOOST_CHECK(reader.feed(json.substr(0, split)));
+        BOOST_CHECK(reader.feed(json.substr(split)));
+        BOOST_CHECK(reader.finish());
+        BOOST_CHECK_EQUAL(reader.root(), expected);
+        BOOST_CHECK_EQUAL(reader.errorPos(), std::string_view::npos);
+    }
+    reader.reset();
+    for (const char c : json)
+        BOOST_CHECK(reader.feed(&c, 1));
+    BOOST_CHECK(reader.finish());
+    BOOST_CHECK_EQUAL(UniValue::stringify(*reader), UniValue::stringify(expected));
+
+    // tokens split across chunks
+    reader.reset();
+    for (const std::string_view chunk : {"[\"a\\", "\"b\\\\\", \"\\u00", "e9\", -1", "2.5e", "+3, tr", "ue, n", "ull]"})
+        BOOST_CHECK(reader.feed(chunk));
+    BOOST_CHECK(reader.finish());
+    BOOST_CHECK_EQUAL(UniValue::stringify(*reader), "[\"a\\\"b\\\\\",\"\u00e9\",-12.5e+3,true,null]");
+
+    // errors are detected as soon as possible, at the same position as read() reports them
+    reader.reset();
+    BOOST_CHECK(reader.feed(std::string_view{"[1, 2"}));
+    BOOST_CHECK(!reader.feed(std::string_view{",]"}));
+    BOOST_CHECK_EQUAL(reader.errorPos(), 7);
+    BOOST_CHECK(!reader.feed(std::string_view{"3]"})); // further input is ignored
+    BOOST_CHECK(!reader.finish());
+    BOOST_CHECK_EQUAL(reader.errorPos(), 7);
+    reader.reset();
+    BOOST_CHECK(reader.feed(std::string_view{"[1, tr"}));
+    BOOST_CHECK(!reader.feed(std::string_view{"ux]"}));
+    BOOST_CHECK_EQUAL(reader.errorPos(), 7);
+    reader.reset();
+    BOOST_CHECK(reader.feed(std::string_view{"{\"a\": [1, 2] "}));
+    BOOST_CHECK(!reader.finish()); // premature end of input
+    BOOST_CHECK_EQUAL(reader.errorPos(), 13);
+    reader.reset();
+    BOOST_CHECK(reader.feed(std::string_view{"1 "}));
+    BOOST_CHECK(reader.feed(std::string_view{"2"})); // junk after the document, but the number may still continue
+    BOOST_CHECK(!reader.finish());
+    BOOST_CHECK_EQUAL(reader.errorPos(), 3);
+    reader.reset();
+    BOOST_CHECK(!reader.finish()); // no document at all
+    BOOST_CHECK_EQUAL(reader.errorPos(), 0);
+
+    // objects and arrays are allocated from the memory resource
+    std::pmr::unsynchronized_pool_resource pool;
+    UniValue::StreamReader poolReader(&pool);
+    BOOST_CHECK(poolReader.feed(json.substr(0, 40)));
+    BOOST_CHECK(poolReader.feed(json.substr(40)));
+    BOOST_CHECK(poolReader.finish());
+    BOOST_CHECK_EQUAL(poolReader.root(), expected);
+    BOOST_CHECK(AllocatedFrom(*poolReader, &pool));
+}
+
+BOOST_AUTO_TEST_CASE(univalue_sax)
+{
+    // Records the events as text
+    struct Recorder : UniValue::SaxHandler {
+        std::string events;
+        size_t stopAfter = std::numeric_limits<size_t>::max();
+        bool add(std::string_view event) {
+            events.append(event).push_back(' ');
+            return --stopAfter > 0;
+        }
+        bool onNull() override { return add("null"); }
+        bool onBool(bool b) override { return add(b ? "true" : "false"); }
+        bool onNumber(std::string_view n) override { return add("num:" + std::string(n)); }
+        bool onString(std::string_view s) override { return add("str:" + std::string(s)); }
+        bool onStartObject() override { return add("{"); }
+        bool onKey(std::string_view k) override { return add("key:" + std::string(k)); }
+        bool onEndObject(size_t n) override { return add("}" + std::to_string(n)); }
+        bool onStartArray() override { return add("["); }
+        bool onEndArray(size_t n) override { return add("]" + std::to_string(n)); }
+    } rec;
+    const std::string_view json = R"({"a": [1, -2.5e3, "x\ty"], "b\u00e9": {}, "c": [], "d": [null, true, false]})";
+    std::string_view::size_type errpos{};
+    BOOST_CHECK(UniValue::readSax(json, rec, &errpos));
+    BOOST_CHECK_EQUAL(errpos, std::string_view::npos);
+    BOOST_CHECK_EQUAL(rec.events, "{ key:a [ num:1 num:-2.5e3 str:x\ty ]3 key:b\u00e9 { }0 key:c [ ]0 key:d [ null true false ]3 }4 ");
+
+    // a handler may stop the parse
+    rec.events.clear();
+    rec.stopAfter = 3;
+    BOOST_CHECK(!UniValue::readSax(json, rec, &errpos));
+    BOOST_CHECK_EQUAL(rec.events, "{ key:a [ ");
+    BOOST_CHECK_EQUAL(errpos, 7);
+
+    // invalid input is rejected at the same position as read() rejects it, after the events that precede the error
+    rec.events.clear();
+    rec.stopAfter = std::numeric_limits<size_t>::max();
+    BOOST_CHECK(!UniValue::readSax(std::string_view{"[1, 2,]"}, rec, &errpos));
+    BOOST_CHECK_EQUAL(errpos, 7);
+    BOOST_CHECK_EQUAL(rec.events, "[ num:1 num:2 ");
+    UniValue::SaxHandler ignore;
+    BOOST_CHECK(!UniValue::readSax(std::string_view{"{\"a\" 1}"}, ignore, &errpos));
+    BOOST_CHECK_EQUAL(errpos, 6);
+    BOOST_CHECK(UniValue::readSax(std::string_view{json1}, ignore));
+
+    // aggregating a field without building a tree
+    struct SumFees : UniValue::SaxHandler {
+        bool isFee = false;
+        int64_t sum = 0;
+        bool onKey(std::string_view k) override { isFee = k == "fee"; return true; }
+        bool onNumber(std::string_view n) override {
+            if (isFee) sum += UniValue(UniValue::VNUM, std::string(n)).get_int64();
+            return true;
+        }
+    } fees;
+    BOOST_CHECK(UniValue::readSax(std::string_view{R"({"tx1": {"fee": 10, "size": 7}, "tx2": {"size": 1, "fee": 32}})"},
+                                  fees));
+    BOOST_CHECK_EQUAL(fees.sum, 42);
+}
+
+// Returns true if `lazy` and everything within it matches `v`, when navigated to in every possible way.
+static bool LazyMatches(const UniValue::LazyValue &lazy, const UniValue &v)
+{
+    if (lazy.type() != v.type() || lazy.size() != v.size() || !(lazy.materialize() == v))
+        return false;
+    size_t i = 0;
+    for (auto it = lazy.begin(); it != lazy.end(); ++it, ++i) {
+        if (v.isObject() && (it.key() != v.get_obj().begin()[i].first || !v.locate(it.key())
+                             || !LazyMatches(lazy[it.key()], *v.locate(it.key()))))
+            return false;
+        if (!LazyMatches(*it, v[i]) || !LazyMatches(lazy[i], v[i]) || !LazyMatches(lazy.at(i), v.at(i)))
+            return false;
+    }
+    return i == v.size();
+}
+
+BOOST_AUTO_TEST_CASE(univalue_lazy_document)
+{
+    const std::string json = std::string(json1) + "  ";
+    UniValue expected;
+    BOOST_CHECK(expected.read(json));
+
+    UniValue::LazyDocument doc;
+    BOOST_CHECK(doc.root().isNull());
+    BOOST_CHECK(doc.read(json));
+    BOOST_CHECK(LazyMatches(doc.root(), expected));
+
+    const std::string_view json2 = R"( {"a\u0062": [1, "two", {"three": 3.5}, [], {}], "x": null, "t": true, "f": false,
+                                       "s": "str\ning", "n": -12, "o": {"p": [[["deep"]]]}} )";
+    BOOST_CHECK(expected.read(json2));
+    BOOST_CHECK(doc.read(json2));
+    BOOST_CHECK(LazyMatches(doc.root(), expected));
+
+    // accessors
+    const UniValue::LazyValue root = doc.root();
+    BOOST_CHECK(root.isObject());
+    BOOST_CHECK_EQUAL(root.size(), 7);
+    BOOST_CHECK_EQUAL(root["ab"].size(), 5);
+    BOOST_CHECK_EQUAL(root["ab"][1].get_str(), "two");
+    BOOST_CHECK_EQUAL(root["ab"][2]["three"].get_real(), 3.5);
+    BOOST_CHECK_EQUAL(root["ab"][2]["three"].getValStr(), "3.5");
+    BOOST_CHECK(root["ab"][3].isArray() && root["ab"][3].empty());
+    BOOST_CHECK(root["x"].isNull());
+    BOOST_CHECK(root["t"].isTrue() && root["t"].get_bool());
+    BOOST_CHECK(root["f"].isFalse() && !root["f"].get_bool());
+    BOOST_CHECK_EQUAL(root["s"].get_str(), "str\ning");
+    BOOST_CHECK_EQUAL(root["n"].get_int64(), -12);
+    BOOST_CHECK_EQUAL(root["n"].get_int(), -12);
+    BOOST_CHECK_THROW(root["n"].get_uint(), std::runtime_error);
+    BOOST_CHECK_THROW(root["n"].get_uint64(), std::runtime_error);
+    BOOST_CHECK_EQUAL(root["ab"][0].get_uint(), 1U);
+    BOOST_CHECK_EQUAL(root["ab"][0].get_uint64(), 1U);
+    BOOST_CHECK_EQUAL(root["o"]["p"][0][0][0].get_str(), "deep");
+    BOOST_CHECK_EQUAL(UniValue::stringify(root["o"].materialize()), R"({"p":[[["deep"]]]})");
+    BOOST_CHECK_EQUAL(root[1].type(), UniValue::VNULL); // by index, regardless of key
+
+    // missing keys and indices, and wrong types
+    BOOST_CHECK(root["missing"].isNull());
+    BOOST_CHECK(!root.locate("missing"));
+    BOOST_CHECK(root.locate("x") && root.locate("x")->isNull());
+    BOOST_CHECK(root[7].isNull());
+    BOOST_CHECK(root["s"]["key"].isNull());
+    BOOST_CHECK(root["s"][0].isNull());
+    BOOST_CHECK(root["s"].begin() == root["s"].end());
+    BOOST_CHECK_THROW(root.at("missing"), std::out_of_range);
+    BOOST_CHECK_THROW(root.at(7), std::out_of_range);
+    BOOST_CHECK_THROW(root["ab"].at("key"), std::domain_error);
+    BOOST_CHECK_THROW(root["s"].at(0), std::domain_error);
+    BOOST_CHECK_THROW(root["s"].get_int64(), std::runtime_error);
+    BOOST_CHECK(UniValue::LazyValue{}.materialize().isNull());
+
+    // the index is built without unescaping strings: escapes cost no more allocations than plain text of the same shape
+    const auto AllocationsToIndex = [&doc](const std::string &json) {
+        const size_t before = g_allocations;
+        BOOST_CHECK(doc.read(json));
+        return g_allocations - before;
+    };
+    std::string plain(1000, 'x'), escaped;
+    for (int i = 0; i < 500; ++i)
+        escaped += "\\n";
+    doc.clear();
+    const size_t plainAllocations = AllocationsToIndex("[{\"" + plain + "\": \"" + plain + "\"}]");
+    doc.clear();
+    BOOST_CHECK_EQUAL(AllocationsToIndex("[{\"" + escaped + "\": \"" + escaped + "\"}]"), plainAllocations);
+
+    // scalar documents
+    BOOST_CHECK(doc.read(std::string_view{" 42 "}));
+    BOOST_CHECK_EQUAL(doc.root().get_int64(), 42);
+    BOOST_CHECK(doc.read(std::string_view{"\"s\""}));
+    BOOST_CHECK_EQUAL(doc.root().get_str(), "s");
+
+    // errors are reported just like UniValue::read(), and leave the document empty
+    std::string_view::size_type errpos{};
+    BOOST_CHECK(!doc.read(std::string_view{"[1, 2,]"}, &errpos));
+    BOOST_CHECK_EQUAL(errpos, 7);
+    BOOST_CHECK(doc.root().isNull());
+    BOOST_CHECK(doc.read(std::string_view{"[1, 2]"}, &errpos));
+    BOOST_CHECK_EQUAL(errpos, std::string_view::npos);
+    doc.clear();
+    BOOST_CHECK(doc.root().isNull());
+}
+
+BOOST_AUTO_TEST_CASE(univalue_read_parallel)
+{
+    // a large array, and a large object, of various members and elements
+    std::string arr = "[", obj = " {\n";
+    for (int i = 0; i < 20000; ++i) {
+        const std::string item = i % 3 == 0 ? "{\"id\": " + std::to_string(i) + ", \"tags\": [\"a,b\", \"]\"], \"ok\": true}"
+                                 : i % 3 == 1 ? "\"str,ing \\\"], \\\\" + std::to_string(i) + "\""
+                                              : "[" + std::to_string(i) + ".5, null, {}]";
+        arr += (i ? ", " : "") + item;
+        obj += (i ? ",\n\"k" : "\"k") + std::to_string(i) + "\": " + item;
+    }
+    arr += "]";
+    obj += "\n}\n";
+
+    for (const auto &json : {arr, obj}) {
+        UniValue expected;
+        BOOST_CHECK(expected.read(json));
+        for (const unsigned threads : {0u, 1u, 2u, 4u, 7u}) {
+            UniValue v{"something else"};
+            std::string_view::size_type errpos{};
+            BOOST_CHECK(v.readParallel(json, &errpos, threads));
+            BOOST_CHECK_EQUAL(errpos, std::string_view::npos);
+            BOOST_CHECK_EQUAL(v, expected);
+        }
+
+        // errors anywhere are reported just like read()
+        for (const size_t pos : {size_t{0}, json.size() / 3, json.size() / 2, json.size() - 1}) {
+            for (const char c : {',', ']', '}', '"', 'x'}) {
+                std::string bad = json;
+                bad[pos] = c;
+                UniValue v, v2;
+                std::string_view::size_type errpos{}, errpos2{};
+                BOOST_CHECK_EQUAL(v.readParallel(bad, &errpos, 4), v2.read(bad, &errpos2));
+                BOOST_CHECK_EQUAL(errpos, errpos2);
+                BOOST_CHECK_EQUAL(v, v2);
+            }
+        }
+        UniValue v;
+        BOOST_CHECK(!v.readParallel("x" + json, nullptr, 4));
+        BOOST_CHECK(!v.readParallel(json + "x", nullptr, 4));
+        BOOST_CHECK(!v.readParallel(json + json, nullptr, 4));
+    }
+
+    // objects and arrays only: the first item of each thread's run must not be sized like the last item of the previous
+    // run, which another thread is still reading (run this under -fsanitize=thread)
+    std::string mixed = "[";
+    for (int i = 0; i < 20000; ++i) {
+        mixed += i ? ", " : "";
+        mixed += i % 4 < 2 ? "{\"a\": [1, 2, 3], \"b\": {\"c\": " + std::to_string(i) + "}, \"d\": \"e\"}"
+                           : "[[" + std::to_string(i) + "], {\"f\": [true]}, [], null]";
+    }
+    mixed += "]";
+    UniValue expectedMixed;
+    BOOST_CHECK(expectedMixed.read(mixed));
+    for (int round = 0; round < 8; ++round) {
+        for (const unsigned threads : {2u, 4u, 7u}) {
+            UniValue v;
+            BOOST_CHECK(v.readParallel(mixed, nullptr, threads));
+            BOOST_CHECK_EQUAL(v, expectedMixed);
+        }
+    }
+
+    // the nesting depth (at most 512) is limited just like read()
+    for (const size_t depth : {size_t{512}, size_t{513}}) {
+        const std::string json = "[0, " + std::string(depth - 1, '[') + std::string(depth - 1, ']') + ", 1]";
+        UniValue v, v2;
+        BOOST_CHECK_EQUAL(v.readParallel(json, nullptr, 2), v2.read(json));
+        BOOST_CHECK_EQUAL(v, v2);
+    }
+
+    // small and scalar documents are simply read
+    UniValue v;
+    BOOST_CHECK(v.readParallel("[]", nullptr, 4) && v.empty() && v.isArray());
+    BOOST_CHECK(v.readParallel("{\"a\": 1}", nullptr, 4) && v["a"].get_int() == 1);
+    BOOST_CHECK(v.readParallel("\"x\"", nullptr, 4) && v.get_str() == "x");
+}
+
+BOOST_AUTO_TEST_CASE(univalue_lines)
+{
+    // enough lines for several batches, with blank lines and "\r\n" line endings mixed in
+    UniValue::Array values;
+    std::string text;
+    std::vector<size_t> lineOf; // the line number of each value
+    size_t line = 0;
+    for (int i = 0; i < 30000; ++i) {
+        UniValue v{UniValue::VOBJ};
+        v.get_obj().emplace_back("seq", i);
+        v.get_obj().emplace_back("msg", "event " + std::to_string(i) + " \"quoted\"\n");
+        v.get_obj().emplace_back("tags", i % 2 ? UniValue{UniValue::VARR} : UniValue{i % 3 == 0});
+        text += UniValue::stringify(v) + (i % 7 == 0 ? "\r\n" : "\n");
+        lineOf.push_back(line++);
+        if (i % 100 == 0) {
+            text += i % 200 ? " \t\n" : "\n";
+            ++line;
+        }
+        values.push_back(std::move(v));
+    }
+    text += "  [\"last line\", \"without a newline\"]  ";
+    lineOf.push_back(line);
+    values.push_back(UniValue::Array{UniValue{"last line"}, UniValue{"without a newline"}});
+
+    for (const unsigned threads : {0u, 1u, 2u, 5u}) {
+        // in order
+        std::vector<UniValue> read;
+        std::vector<size_t> lines;
+        std::string_view::size_type errpos{};
+        BOOST_CHECK(UniValue::readLines(text, [&](size_t l, UniValue &&v) {
+            lines.push_back(l);
+            read.push_back(std::move(v));
+            return true;
+        }, &errpos, true, threads));
+        BOOST_CHECK_EQUAL(errpos, std::string_view::npos);
+        BOOST_CHECK(lines == lineOf);
+        BOOST_CHECK(std::equal(read.begin(), read.end(), values.begin(), values.end()));
+
+        // in any order
+        std::vector<std::pair<size_t, UniValue>> unordered;
+        BOOST_CHECK(UniValue::readLines(text, [&](size_t l, UniValue &&v) {
+            unordered.emplace_back(l, std::move(v));
+            return true;
+        }, nullptr, false, threads));
+        std::sort(unordered.begin(), unordered.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+        BOOST_CHECK_EQUAL(unordered.size(), values.size());
+        for (size_t i = 0; i < unordered.size() && i < values.size(); ++i) {
+            BOOST_CHECK_EQUAL(unordered[i].first, lineOf[i]);
+            BOOST_CHECK_EQUAL(unordered[i].second, values.begin()[i]);
+        }
+
+        // an invalid line stops the reading, after the lines before it have been delivered
+        std::string bad = text;
+        const size_t badPos = text.find("\"seq\":20000");
+        bad.insert(badPos, "x");
+        size_t count = 0;
+        BOOST_CHECK(!UniValue::readLines(bad, [&](size_t, UniValue &&) { ++count; return true; }, &errpos, true,
+                                         threads));
+        BOOST_CHECK_EQUAL(errpos, badPos); // at the "x"
+        BOOST_CHECK_EQUAL(count, 20000);
+
+        // so does the handler
+        count = 0;
+        BOOST_CHECK(!UniValue::readLines(text, [&](size_t, UniValue &&) { return ++count < 3; }, &errpos, true,
+                                         threads));
+        BOOST_CHECK_EQUAL(count, 3);
+        BOOST_CHECK_EQUAL(errpos, text.find('\n', text.find("\"seq\":2,")));
+
+        // and writeLines() is the inverse of readLines()
+        const std::string written = UniValue::writeLines(values, threads);
+        std::string expected;
+        for (const auto &v : values)
+            expected += UniValue::stringify(v) + "\n";
+        BOOST_CHECK_EQUAL(written, expected);
+    }
+
+    // empty input
+    BOOST_CHECK(UniValue::readLines("", [](size_t, UniValue &&) { return false; }));
+    BOOST_CHECK(UniValue::readLines("\n \n", [](size_t, UniValue &&) { return false; }));
+    BOOST_CHECK_EQUAL(UniValue::writeLines(UniValue::Array{}), "");
+    BOOST_CHECK_EQUAL(UniValue::writeLines(UniValue::Array{UniValue{1}, UniValue{}}, 2), "1\nnull\n");
+
+    // files
+    const auto path = (std::filesystem::temp_directory_path() / "univalue_lines_test.ndjson").string();
+    std::ofstream(path, std::ios::binary) << "{\"a\": 1}\n[2]\n";
+    std::vector<UniValue> read;
+    BOOST_CHECK(UniValue::readLinesFile(path, [&](size_t, UniValue &&v) { read.push_back(std::move(v)); return true; }));
+    BOOST_CHECK_EQUAL(read.size(), 2);
+    std::filesystem::remove(path);
+    BOOST_CHECK_THROW((void)UniValue::readLinesFile(path, [](size_t, UniValue &&) { return true; }), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(univalue_read_file)
+{
+    const auto path = (std::filesystem::temp_directory_path() / "univalue_read_file_test.json").string();
+    const auto writeFile = [&path](const std::string &contents) {
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << contents;
+    };
+
+    // the file is parsed just as read() parses its contents, whatever its size (such as exactly one page)
+    std::string json = "{\"a\": [1, 2.5, \"x\"], \"b\": null}";
+    for (const size_t size : {json.size(), size_t{4096}, size_t{65536 + 17}}) {
+        json.resize(size, ' ');
+        writeFile(json);
+        UniValue expected, v;
+        BOOST_CHECK(expected.read(json));
+        std::string_view::size_type errpos{};
+        BOOST_CHECK(v.readFile(path, &errpos));
+        BOOST_CHECK_EQUAL(errpos, std::string_view::npos);
+        BOOST_CHECK_EQUAL(v, expected);
+
+        const UniValue::MappedFile file(path);
+        BOOST_CHECK_EQUAL(file.view(), json);
+#if defined(__unix__) || defined(__APPLE__)
+        BOOST_CHECK(file.isMapped());
+#endif
+    }
+
+    // errors are reported as offsets in the file
+    writeFile("[1, 2,]");
+    UniValue v;
+    std::string_view::size_type errpos{};
+    BOOST_CHECK(!v.readFile(path, &errpos));
+    BOOST_CHECK_EQUAL(errpos, 7);
+
+    // an empty file is not mapped, but is still (invalid) JSON
+    writeFile("");
+    BOOST_CHECK(!v.readFile(path, &errpos));
+    BOOST_CHECK_EQUAL(UniValue::MappedFile(path).size(), 0);
+
+    std::filesystem::remove(path);
+    BOOST_CHECK_THROW((void)v.readFile(path), std::runtime_error);
+    BOOST_CHECK_THROW(UniValue::MappedFile{path}, std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(univalue_read_filtered)
+{
+    const std::string json = R"({"hash": "h", "height": 5, "tx": [{"txid": "a", "vin": [{"txid": "in"}], "size": 1},
+                                {"size": 2}, {"txid": "b"}, 7], "extra": {"txid": "no"}, "a/b": {"~c": [true, false]}})";
+    const auto filtered = [&json](std::initializer_list<std::string_view> paths) {
+        UniValue v{"something else"};
+        std::string_view::size_type errpos{};
+        BOOST_CHECK(v.readFiltered(json, UniValue::PathFilter(paths), &errpos));
+        BOOST_CHECK_EQUAL(errpos, std::string_view::npos);
+        return UniValue::stringify(v);
+    };
+
+    BOOST_CHECK_EQUAL(filtered({"/tx/*/txid", "/height"}), R"({"height":5,"tx":[{"txid":"a"},{"txid":"b"}]})");
+    BOOST_CHECK_EQUAL(filtered({"/tx/1"}), R"({"tx":[{"size":2}]})");
+    BOOST_CHECK_EQUAL(filtered({"/tx/*/txid", "/tx/0"}),
+                      R"({"tx":[{"txid":"a","vin":[{"txid":"in"}],"size":1},{"txid":"b"}]})");
+    BOOST_CHECK_EQUAL(filtered({"/*/txid"}), R"({"extra":{"txid":"no"}})");
+    BOOST_CHECK_EQUAL(filtered({"/tx/*/*/*/txid"}), R"({"tx":[{"vin":[{"txid":"in"}]}]})");
+    BOOST_CHECK_EQUAL(filtered({"/a~1b/~0c/1"}), R"({"a/b":{"~c":[false]}})");
+    BOOST_CHECK_EQUAL(filtered({"/tx/3"}), R"({"tx":[7]})");
+    BOOST_CHECK_EQUAL(filtered({"/tx/03", "/tx/x"}), "null"); // not indices, and the elements have no members
+    BOOST_CHECK_EQUAL(filtered({"/height/x", "/missing"}), "null");
+    BOOST_CHECK_EQUAL(filtered({}), "null");
+
+    // the empty path selects the whole document
+    UniValue expected;
+    BOOST_CHECK(expected.read(json));
+    BOOST_CHECK_EQUAL(filtered({""}), UniValue::stringify(expected));
+    BOOST_CHECK_EQUAL(filtered({"", "/tx/*/txid"}), UniValue::stringify(expected));
+
+    // the skipped parts are validated just like read() validates them
+    const UniValue::PathFilter filter{"/height"};
+    for (const std::string_view bad : {R"({"height": 1, "x": [1, 2,]})", R"({"x": {"y": tru}, "height": 1})",
+                                       R"({"height": 1} 2)", R"([1, 2, {"height": "x"})"}) {
+        UniValue v, v2;
+        std::string_view::size_type errpos{}, errpos2{};
+        BOOST_CHECK(!v.readFiltered(bad, filter, &errpos));
+        BOOST_CHECK(!v2.read(bad, &errpos2));
+        BOOST_CHECK_EQUAL(errpos, errpos2);
+    }
+
+    // skipping allocates no memory, even for strings that have to be unescaped to be validated
+    std::string skipped = R"({"height": 1, "skipped": {"a very long key with an escape: \n": [)";
+    for (int i = 0; i < 100; ++i)
+        skipped += R"("a very long string with escapes: \"\\\u00e9\t", )";
+    skipped += R"({"\u0041nother long key, escaped": "and a long value, also \"escaped\""}]}})";
+    const auto AllocationsToRead = [&filter](const std::string &json) {
+        UniValue v;
+        const size_t before = g_allocations;
+        BOOST_CHECK(v.readFiltered(json, filter));
+        const size_t allocations = g_allocations - before;
+        BOOST_CHECK_EQUAL(UniValue::stringify(v), R"({"height":1})");
+        return allocations;
+    };
+    BOOST_CHECK(UniValue().read(skipped));
+    BOOST_CHECK_EQUAL(AllocationsToRead(skipped), AllocationsToRead(R"({"height": 1})")); // i.e. those of the result
+
+    // invalid paths
+    BOOST_CHECK_THROW(UniValue::PathFilter({"height"}), std::invalid_argument);
+    BOOST_CHECK_THROW(UniValue::PathFilter({"/a~2"}), std::invalid_argument);
+    BOOST_CHECK_THROW(UniValue::PathFilter({"/a~"}), std::invalid_argument);
+
+    // the automaton
+    const UniValue::PathFilter paths{"/tx/*/txid", "/tx/0"};
+    const size_t tx = paths.next(0, "tx");
+    BOOST_CHECK_EQUAL(paths.next(0, "height"), UniValue::PathFilter::npos);
+    BOOST_CHECK(!paths.isSelected(tx));
+    BOOST_CHECK(paths.isSelected(paths.next(tx, "0")));
+    BOOST_CHECK(paths.isSelected(paths.next(paths.next(tx, "0"), "anything")));
+    BOOST_CHECK(!paths.isSelected(paths.next(tx, "1")));
+    BOOST_CHECK(paths.isSelected(paths.next(paths.next(tx, "1"), "txid")));
+}
+
+BOOST_AUTO_TEST_CASE(univalue_validate)
+{
+    // validate() accepts and rejects exactly what read() does, reporting the same error position
+    const std::string deep = std::string(512, '[') + std::string(512, ']');
+    const std::string tooDeep = "[" + deep + "]";
+    const std::string_view docs[] = {
+        R"({"a": [1, -2.5e+3, "xé𝄞\n\"", true, false, null], "b": {}})",
+        "\"\xc3\xa9\xe2\x82\xac\xf0\x9d\x84\x9e\"", // valid UTF-8
+        "\"\xc3\"", "\"\xe2\x82\"", "\"\xff\"", "\"\xc0\xaf\"", // invalid UTF-8
+        R"("\ud834")", R"("\udd1e\ud834")", R"("\u12")", R"("\x")", "\"a\tb\"", // bad escapes, control character
+        R"({"a" 1})", R"([1,])", R"([01])", R"(1 2)", "", " ", "nul", "[1e]", deep, tooDeep,
+    };
+    for (const auto json : docs) {
+        UniValue v;
+        std::string_view::size_type errpos{}, errpos2{};
+        const bool ok = v.read(json, &errpos);
+        BOOST_CHECK_EQUAL(UniValue::validate(json, &errpos2), ok);
+        BOOST_CHECK_EQUAL(errpos2, errpos);
+
+        const char *errptr = nullptr;
+        BOOST_CHECK_EQUAL(UniValue::validate(json.data(), json.size(), &errptr), ok);
+        BOOST_CHECK(ok ? errptr == nullptr : errptr == json.data() + errpos);
+    }
+    BOOST_CHECK(UniValue::validate(docs[0]));
+    BOOST_CHECK(UniValue::validate(deep));
+    BOOST_CHECK(!UniValue::validate(tooDeep));
+}
+
+BOOST_AUTO_TEST_CASE(univalue_shape)
+{
+    UniValue records;
+    BOOST_CHECK(records.read(R"([{"id": 1, "fee": 10, "size": 200}, {"id": 2, "fee": 20, "size": 300},
+                                  {"fee": 30, "id": 3}, {"id": 4, "fee": 40, "size": 500, "extra": true},
+                                  {}, {"id": 6, "id": 7, "fee": 60}])"));
+    // objects that follow a sibling of the same shape are read the same as any other
+    BOOST_CHECK_EQUAL(UniValue::stringify(records[1]), R"({"id":2,"fee":20,"size":300})");
+    BOOST_CHECK_EQUAL(UniValue::stringify(records[3]), R"({"id":4,"fee":40,"size":500,"extra":true})");
+
+    // a large sibling is not followed, since reserving its size for each of many small siblings would waste memory
+    const auto BytesToRead = [](const std::string &json) {
+        UniValue v;
+        const size_t before = g_allocatedBytes;
+        BOOST_CHECK(v.read(json));
+        return g_allocatedBytes - before;
+    };
+    const auto BytesOfSmallSiblings = [&](const std::string &first) {
+        std::string json = "[" + first;
+        for (int i = 0; i < 100; ++i)
+            json += R"(, [1], {"a": 1})";
+        return BytesToRead(json + "]") - BytesToRead("[" + first + "]");
+    };
+    std::string large = "[0", largeObject = R"({"k0": 0)";
+    for (int i = 1; i < 1000; ++i) {
+        large += ", " + std::to_string(i);
+        largeObject += ", \"k" + std::to_string(i) + "\": 0";
+    }
+    BOOST_CHECK_EQUAL(BytesOfSmallSiblings(large + "]"), BytesOfSmallSiblings("[1]"));
+    BOOST_CHECK_EQUAL(BytesOfSmallSiblings(largeObject + "}"), BytesOfSmallSiblings(R"({"a": 1})"));
+
+    const UniValue::Shape shape(records[0].get_obj());
+    BOOST_CHECK_EQUAL(shape.size(), 3U);
+    BOOST_CHECK_EQUAL(shape.key(1), "fee");
+    BOOST_CHECK(shape.slot("id") == 0U);
+    BOOST_CHECK(shape.slot("size") == 2U);
+    BOOST_CHECK(!shape.slot("extra"));
+    BOOST_CHECK(!shape.slot(""));
+    BOOST_CHECK(shape.matches(records[0].get_obj()));
+    BOOST_CHECK(shape.matches(records[1].get_obj()));
+    BOOST_CHECK(!shape.matches(records[2].get_obj()));
+    BOOST_CHECK(!shape.matches(records[3].get_obj()));
+    BOOST_CHECK(!shape.matches(records[4].get_obj()));
+
+    // locate() agrees with Object::locate() for objects of any shape, and for missing keys
+    for (const auto &record : records.get_array()) {
+        const auto &obj = record.get_obj();
+        for (const std::string_view key : {"id", "fee", "size", "extra", "missing"}) {
+            BOOST_CHECK_EQUAL(shape.locate(obj, key), obj.locate(key));
+            BOOST_CHECK_EQUAL(shape.locate(obj, key, shape.slot(key)), obj.locate(key));
+        }
+    }
+
+    // a shape with a duplicate key gives the slot of its first occurrence
+    const UniValue::Shape dup(records[5].get_obj());
+    BOOST_CHECK(dup.slot("id") == 0U);
+    BOOST_CHECK_EQUAL(dup.locate(records[5].get_obj(), "id")->get_int(), 6);
+
+    // an object of another shape, with the key in the predicted slot and before it, gives its first occurrence
+    UniValue twice;
+    BOOST_CHECK(twice.read(R"({"fee": 1, "fee": 2, "id": 3})"));
+    BOOST_CHECK_EQUAL(shape.locate(twice.get_obj(), "fee")->get_int(), 1);
+    BOOST_CHECK_EQUAL(shape.locate(twice.get_obj(), "fee"), twice.get_obj().locate("fee"));
+
+    const UniValue::Shape empty;
+    BOOST_CHECK_EQUAL(empty.size(), 0U);
+    BOOST_CHECK(empty.matches(records[4].get_obj()));
+    BOOST_CHECK_EQUAL(empty.locate(records[0].get_obj(), "fee"), records[0].get_obj().locate("fee"));
+}
+
+BOOST_AUTO_TEST_CASE(univalue_binary_numbers)
+{
+    // numbers assigned from C++ values give the same text as they always have (see also univalue_readwrite)
+    const std::pair<UniValue, std::string_view> numbers[] = {
+        {0, "0"}, {-1, "-1"}, {1234567890, "1234567890"},
+        {std::numeric_limits<int64_t>::min(), "-9223372036854775808"},
+        {std::numeric_limits<int64_t>::max(), "9223372036854775807"},
+        {std::numeric_limits<uint64_t>::max(), "18446744073709551615"},
+        {0.0, "0"}, {-0.0, "-0"}, {5.0, "5"}, {0.1 + 0.2, "0.3"}, {1.0 / 3, "0.3333333333333333"},
+        {1e300, "1e+300"}, {-2.5e-8, "-2.5e-08"}, {std::numeric_limits<double>::denorm_min(), "4.940656458412465e-324"},
+    };
+    for (const auto &[num, text] : numbers) {
+        BOOST_CHECK(num.isNum());
+        BOOST_CHECK_EQUAL(num.getValStr(), text);
+        BOOST_CHECK_EQUAL(&num.getValStr(), &num.getValStr()); // made once, then kept
+        BOOST_CHECK_EQUAL(UniValue::stringify(num), text);
+        BOOST_CHECK(num == UniValue(UniValue::VNUM, std::string(text)));
+        BOOST_CHECK(UniValue(UniValue::VNUM, std::string(text)) == num);
+        UniValue copy(num), moved(std::move(copy));
+        BOOST_CHECK(moved == num);
+        BOOST_CHECK_EQUAL(moved.getValStr(), text);
+    }
+    BOOST_CHECK(UniValue(5) == UniValue(5U));
+    BOOST_CHECK(UniValue(5) == UniValue(5.0));
+    BOOST_CHECK(UniValue(5) != UniValue(6));
+    BOOST_CHECK(UniValue(0.1) != UniValue(0.2));
+    BOOST_CHECK(UniValue(std::numeric_limits<double>::infinity()).isNull());
+
+    // the getters accept and reject the same values as when parsing the text
+    BOOST_CHECK_EQUAL(UniValue(std::numeric_limits<int64_t>::min()).get_int64(), std::numeric_limits<int64_t>::min());
+    BOOST_CHECK_EQUAL(UniValue(std::numeric_limits<uint64_t>::max()).get_uint64(), std::numeric_limits<uint64_t>::max());
+    BOOST_CHECK_THROW(UniValue(std::numeric_limits<uint64_t>::max()).get_int64(), std::runtime_error);
+    BOOST_CHECK_THROW(UniValue(int64_t(1) << 31).get_int(), std::runtime_error);
+    BOOST_CHECK_EQUAL(UniValue(int64_t(1) << 31).get_uint(), 1U << 31);
+    BOOST_CHECK_THROW(UniValue(-1).get_uint64(), std::runtime_error);
+    BOOST_CHECK_THROW(UniValue(-1).get_uint(), std::runtime_error);
+    BOOST_CHECK_EQUAL(UniValue(0).get_uint(), 0U);
+    BOOST_CHECK_EQUAL(UniValue(5.0).get_int(), 5);
+    BOOST_CHECK_THROW(UniValue(5.5).get_int(), std::runtime_error);
+    BOOST_CHECK_EQUAL(UniValue(0.1 + 0.2).get_real(), 0.3);
+    BOOST_CHECK_EQUAL(UniValue(std::numeric_limits<int64_t>::max()).get_real(), 9223372036854775807.0);
+    BOOST_CHECK_EQUAL(UniValue(-7).get_real(), -7.0);
+
+    // threads that read the text of the same number at once all get the one string
+    for (int i = 0; i < 20; ++i) {
+        const UniValue num(1.0 / (i + 3));
+        std::vector<std::future<const std::string *>> results;
+        for (int t = 0; t < 4; ++t)
+            results.push_back(std::async(std::launch::async, [&num] { return &num.getValStr(); }));
+        const std::string *first = results[0].get();
+        for (size_t t = 1; t < results.size(); ++t)
+            BOOST_CHECK_EQUAL(results[t].get(), first);
+        BOOST_CHECK_EQUAL(*first, UniValue::stringify(num));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(univalue_get_real)
+{
+    const auto Real = [](const char *json) {
+        UniValue v;
+        BOOST_CHECK(v.read(json));
+        return v.get_real();
+    };
+    BOOST_CHECK_EQUAL(Real("32520.00000000"), 32520.0);
+    BOOST_CHECK_EQUAL(Real("0.00012345"), 0.00012345);
+    BOOST_CHECK_EQUAL(Real("-1.5e3"), -1500.0);
+    BOOST_CHECK_EQUAL(Real("0.1"), 0.1);
+    BOOST_CHECK_EQUAL(Real("0.30000000000000004"), 0.1 + 0.2);
+    BOOST_CHECK_EQUAL(Real("9007199254740993"), 9007199254740992.0); // 2^53 + 1 rounds to even
+    BOOST_CHECK_EQUAL(Real("2.2250738585072011e-308"), 2.2250738585072011e-308);
+    BOOST_CHECK_EQUAL(Real("1.7976931348623157e308"), std::numeric_limits<double>::max());
+    BOOST_CHECK_EQUAL(Real("4.9406564584124654e-324"), std::numeric_limits<double>::denorm_min());
+    BOOST_CHECK_EQUAL(Real("0.1000000000000000055511151231257827021181583404541015625000000001"), 0.1);
+    BOOST_CHECK_EQUAL(Real("123456789012345678901234567890"), 1.2345678901234568e29);
+    BOOST_CHECK(std::signbit(Real("-0")) && Real("-0") == 0.0);
+    BOOST_CHECK_EQUAL(Real("0e999999"), 0.0);
+    BOOST_CHECK_EQUAL(Real("1e-400"), 0.0); // underflow is accepted, as 0
+    BOOST_CHECK(std::signbit(Real("-1e-400")));
+    UniValue v;
+    BOOST_CHECK(v.read("1e400"));
+    BOOST_CHECK_THROW(v.get_real(), std::runtime_error); // overflow is not
+    BOOST_CHECK(v.read("-1.8e308"));
+    BOOST_CHECK_THROW(v.get_real(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(univalue_real_format)
+{
+    using RealFormat = UniValue::RealFormat;
+    const std::tuple<double, std::string_view, std::string_view> doubles[] = {
+        // value, shortest, legacy
+        {0.1 + 0.2, "0.30000000000000004", "0.3"},
+        {1.0 / 3, "0.3333333333333333", "0.3333333333333333"},
+        {-40.1, "-40.1", "-40.1"},
+        {1e21, "1e+21", "1e+21"},
+        {123456789.0, "123456789", "123456789"},
+        // the notation is that of printf("%.16g") for both
+        {100000.0, "100000", "100000"},
+        {1e6, "1000000", "1000000"},
+        {123456789012.0, "123456789012", "123456789012"},
+        {1e15, "1000000000000000", "1000000000000000"},
+        {1e16, "1e+16", "1e+16"},
+        {1152921504606846976.0, "1.152921504606847e+18", "1.152921504606847e+18"},
+        {0.0001, "0.0001", "0.0001"},
+        {-0.00012345678901234567, "-0.00012345678901234567", "-0.0001234567890123457"},
+        {1e-5, "1e-05", "1e-05"},
+        {1.5e-100, "1.5e-100", "1.5e-100"},
+        {0.0, "0", "0"},
+        {-0.0, "-0", "-0"},
+        {std::numeric_limits<double>::max(), "1.7976931348623157e+308", "1.797693134862316e+308"},
+        {std::numeric_limits<double>::min(), "2.2250738585072014e-308", "2.225073858507201e-308"},
+        {-std::numeric_limits<double>::denorm_min(), "-5e-324", "-4.940656458412465e-324"},
+    };
+    for (const auto &[d, shortest, legacy] : doubles) {
+        UniValue v;
+        v.setReal(d, RealFormat::Shortest);
+        BOOST_CHECK_EQUAL(v.getValStr(), shortest);
+        BOOST_CHECK_EQUAL(UniValue::stringify(v), shortest);
+        BOOST_CHECK_EQUAL(v.get_real(), d); // the shortest text always reads back as the same double
+        BOOST_CHECK_EQUAL(v == UniValue(d), shortest == legacy);
+        UniValue parsed;
+        BOOST_CHECK(parsed.read(UniValue::stringify(v)));
+        BOOST_CHECK_EQUAL(parsed.get_real(), d);
+
+        v.setReal(d, RealFormat::Legacy16);
+        BOOST_CHECK_EQUAL(v.getValStr(), legacy);
+        BOOST_CHECK_EQUAL(UniValue::stringify(v), legacy);
+        BOOST_CHECK(v == UniValue(UniValue::VNUM, std::string(legacy)));
+
+        // the double constructor and operator=(double) always write 16 digits
+        BOOST_CHECK(v == UniValue(d));
+        BOOST_CHECK_EQUAL(UniValue(d).getValStr(), legacy);
+        v = d;
+        BOOST_CHECK_EQUAL(v.getValStr(), legacy);
+    }
+
+    // with 16 digits, get_real() returns the value of the text, which may not be the double assigned (or a double)
+    UniValue v;
+    v.setReal(0.1 + 0.2, RealFormat::Legacy16);
+    BOOST_CHECK_EQUAL(v.get_real(), 0.3);
+    v.setReal(std::numeric_limits<double>::max(), RealFormat::Legacy16);
+    BOOST_CHECK_THROW(v.get_real(), std::runtime_error);
+    v.setReal(std::numeric_limits<double>::quiet_NaN(), RealFormat::Legacy16);
+    BOOST_CHECK(v.isNull());
+    v.setReal(std::numeric_limits<double>::infinity(), RealFormat::Shortest);
+    BOOST_CHECK(v.isNull());
+}
+
+BOOST_AUTO_TEST_CASE(univalue_get_int)
+{
+    const auto Num = [](const char *text) { return UniValue(UniValue::VNUM, text); };
+    BOOST_CHECK_EQUAL(Num("12345678").get_int(), 12345678);
+    BOOST_CHECK_EQUAL(Num("-2147483648").get_int(), std::numeric_limits<int>::min());
+    BOOST_CHECK_THROW(Num("-2147483649").get_int(), std::runtime_error);
+    BOOST_CHECK_THROW(Num("2147483648").get_int(), std::runtime_error);
+    BOOST_CHECK_EQUAL(Num("4294967295").get_uint(), std::numeric_limits<unsigned>::max());
+    BOOST_CHECK_THROW(Num("4294967296").get_uint(), std::runtime_error);
+    BOOST_CHECK_EQUAL(Num("-9223372036854775808").get_int64(), std::numeric_limits<int64_t>::min());
+    BOOST_CHECK_THROW(Num("-9223372036854775809").get_int64(), std::runtime_error);
+    BOOST_CHECK_EQUAL(Num("1234567890123456789").get_int64(), 1234567890123456789);
+    BOOST_CHECK_EQUAL(Num("18446744073709551615").get_uint64(), std::numeric_limits<uint64_t>::max());
+    BOOST_CHECK_THROW(Num("18446744073709551616").get_uint64(), std::runtime_error);
+    BOOST_CHECK_THROW(Num("99999999999999999999").get_uint64(), std::runtime_error);
+    BOOST_CHECK_THROW(Num("123456789012345678901").get_uint64(), std::runtime_error);
+    BOOST_CHECK_EQUAL(Num("-0").get_uint64(), 0U);
+    BOOST_CHECK_THROW(Num("-1").get_uint64(), std::runtime_error);
+    BOOST_CHECK_THROW(Num("1.5").get_int64(), std::runtime_error);
+    BOOST_CHECK_THROW(Num("1e3").get_int64(), std::runtime_error);
+    // not JSON, but accepted as before (with strtoll()), as are leading zeros
+    BOOST_CHECK_EQUAL(Num("+5").get_int(), 5);
+    BOOST_CHECK_EQUAL(Num("-007").get_int(), -7);
+    BOOST_CHECK_EQUAL(Num("000000000000000000000018446744073709551615").get_uint64(), std::numeric_limits<uint64_t>::max());
+    BOOST_CHECK_THROW(Num("-00").get_uint(), std::runtime_error);
+    BOOST_CHECK_THROW(Num(" 5").get_int(), std::runtime_error);
+    BOOST_CHECK_THROW(Num("").get_int(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(univalue_fixed)
+{
+    UniValue v;
+    BOOST_CHECK(v.read(R"({"base": 32520.00000000, "fee": 0.00001234, "dust": 0.000000001, "big": 92233720368.54775807,
+                           "bigger": 92233720368.54775808, "exp": 1.5e-5, "neg": -21000000, "zero": -0.0})"));
+    BOOST_CHECK_EQUAL(v["base"].get_fixed(8), 3252000000000);
+    BOOST_CHECK_EQUAL(v["base"].get_fixed(0), 32520);
+    BOOST_CHECK_EQUAL(v["fee"].get_fixed(8), 1234);
+    BOOST_CHECK_EQUAL(v["fee"].get_fixed(18), 12340000000000);
+    BOOST_CHECK_THROW(v["fee"].get_fixed(7), std::runtime_error); // too precise
+    BOOST_CHECK_THROW(v["dust"].get_fixed(8), std::runtime_error);
+    BOOST_CHECK_EQUAL(v["dust"].get_fixed(9), 1);
+    BOOST_CHECK_EQUAL(v["big"].get_fixed(8), std::numeric_limits<int64_t>::max());
+    BOOST_CHECK_THROW(v["bigger"].get_fixed(8), std::runtime_error); // out of range
+    BOOST_CHECK_EQUAL(v["exp"].get_fixed(8), 1500);
+    BOOST_CHECK_EQUAL(v["neg"].get_fixed(8), -2100000000000000);
+    BOOST_CHECK_EQUAL(v["zero"].get_fixed(8), 0);
+    BOOST_CHECK_THROW(v["base"].get_fixed(19), std::runtime_error);
+    BOOST_CHECK_THROW(UniValue("1").get_fixed(8), std::runtime_error); // not a number
+
+    // numbers assigned from C++ values
+    BOOST_CHECK_EQUAL(UniValue(21).get_fixed(8), 2100000000);
+    BOOST_CHECK_THROW(UniValue(std::numeric_limits<uint64_t>::max()).get_fixed(0), std::runtime_error);
+    BOOST_CHECK_EQUAL(UniValue(std::numeric_limits<int64_t>::min()).get_fixed(0), std::numeric_limits<int64_t>::min());
+    BOOST_CHECK_THROW(UniValue(std::numeric_limits<int64_t>::min()).get_fixed(1), std::runtime_error);
+    BOOST_CHECK_EQUAL(UniValue(0.1).get_fixed(8), 10000000); // by its text, "0.1"
+    v.setReal(0.1 + 0.2, UniValue::RealFormat::Shortest);
+    BOOST_CHECK_THROW(v.get_fixed(8), std::runtime_error); // "0.30000000000000004"
+
+    // the setter, which writes exactly `decimals` decimal places
+    const std::tuple<int64_t, unsigned, std::string_view> fixed[] = {
+        {3252000000000, 8, "32520.00000000"}, {1234, 8, "0.00001234"}, {-1, 8, "-0.00000001"}, {0, 8, "0.00000000"},
+        {-2100000000000000, 8, "-21000000.00000000"}, {42, 0, "42"}, {-5, 1, "-0.5"},
+        {std::numeric_limits<int64_t>::min(), 18, "-9.223372036854775808"},
+        {std::numeric_limits<int64_t>::max(), 18, "9.223372036854775807"},
+        {1, 18, "0.000000000000000001"},
+    };
+    for (const auto &[scaled, decimals, text] : fixed) {
+        v.setFixed(scaled, decimals);
+        BOOST_CHECK(v.isNum());
+        BOOST_CHECK_EQUAL(v.getValStr(), text);
+        BOOST_CHECK_EQUAL(UniValue::stringify(v), text);
+        BOOST_CHECK_EQUAL(v.get_fixed(decimals), scaled);
+        BOOST_CHECK(v == UniValue(UniValue::VNUM, std::string(text)));
+        UniValue parsed;
+        BOOST_CHECK(parsed.read(text));
+        BOOST_CHECK_EQUAL(parsed.get_fixed(decimals), scaled);
+    }
+    v.setFixed(150, 2);
+    BOOST_CHECK_EQUAL(v.get_fixed(1), 15);
+    BOOST_CHECK_EQUAL(v.get_fixed(4), 15000);
+    BOOST_CHECK_THROW(v.get_fixed(0), std::runtime_error);
+    BOOST_CHECK_EQUAL(v.get_real(), 1.5);
+    BOOST_CHECK_THROW(v.get_int(), std::runtime_error); // "1.50" is not an integer
+    v.setFixed(150, 0);
+    BOOST_CHECK_EQUAL(v.get_int(), 150);
+    BOOST_CHECK(UniValue(150) == v);
+    v.setFixed(1500, 1);
+    BOOST_CHECK(UniValue(150) != v); // "150.0"
+    BOOST_CHECK_THROW(v.setFixed(1, 19), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(univalue_to_vector)
+{
+    UniValue v;
+    BOOST_CHECK(v.read("[1, -2, 3000000000, 9223372036854775807, 0, 12345678901234]"));
+    const UniValue::Array &arr = v.get_array();
+    BOOST_CHECK(arr.to_vector<int64_t>() == std::vector<int64_t>({1, -2, 3000000000, 9223372036854775807, 0,
+                                                                  12345678901234}));
+    BOOST_CHECK(arr.to_vector<double>() == std::vector<double>({1, -2, 3e9, 9223372036854775807.0, 0,
+                                                                12345678901234.0}));
+    // as the getters: 3000000000 is too big for an int and -2 is negative
+    BOOST_CHECK_THROW((void)arr.to_vector<int>(), std::runtime_error);
+    BOOST_CHECK_THROW((void)arr.to_vector<uint64_t>(), std::runtime_error);
+    int ints[6] = {};
+    BOOST_CHECK_EQUAL(arr.to_numbers(ints, 6), 2);
+    BOOST_CHECK_EQUAL(ints[0], 1);
+    BOOST_CHECK_EQUAL(ints[1], -2);
+    BOOST_CHECK_EQUAL(ints[2], 0); // left as is
+    uint64_t uints[6] = {};
+    BOOST_CHECK_EQUAL(arr.to_numbers(uints, 6), 1);
+    BOOST_CHECK_EQUAL(uints[0], 1);
+    BOOST_CHECK_EQUAL(arr.to_numbers(uints, 1), 1); // only the first
+    BOOST_CHECK_EQUAL(arr.to_numbers(uints, 0), 0);
+    int64_t int64s[8] = {};
+    BOOST_CHECK_EQUAL(arr.to_numbers(int64s, 8), 6); // only as many as there are
+    BOOST_CHECK_EQUAL(int64s[5], 12345678901234);
+
+    // the first bad index, whatever the reason
+    BOOST_CHECK(v.read(R"([1, 2, 3, "4", 5])"));
+    std::string what;
+    try {
+        (void)v.get_array().to_vector<int>();
+    } catch (const std::runtime_error &e) {
+        what = e.what();
+    }
+    BOOST_CHECK_EQUAL(what, "JSON array value at index 3 is not a number as expected, or is out of range");
+    for (const char *json : {R"([1, 2, 3, null])", R"([1, 2, 3, 4.5])", R"([1, 2, 3, [4]])", R"([1, 2, 3, 1e400])"}) {
+        BOOST_CHECK(v.read(json));
+        BOOST_CHECK_EQUAL(v.get_array().to_numbers(int64s, 8), 3);
+    }
+    BOOST_CHECK(v.read(R"([0.5, -1e-3, 4, 1e400])"));
+    double doubles[4] = {};
+    BOOST_CHECK_EQUAL(v.get_array().to_numbers(doubles, 4), 3);
+    BOOST_CHECK_EQUAL(doubles[0], 0.5);
+    BOOST_CHECK_EQUAL(doubles[1], -1e-3);
+    BOOST_CHECK_EQUAL(doubles[2], 4);
+    BOOST_CHECK(v.read("[]"));
+    BOOST_CHECK(v.get_array().to_vector<double>().empty());
+
+    // numbers assigned from C++ values, and of all lengths, agree with the getters
+    std::vector<int64_t> values;
+    uint64_t x = 42;
+    for (int i = 0; i < 1000; ++i) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        values.push_back(int64_t(x >> (1 + i % 63)) * (i % 7 ? 1 : -1));
+    }
+    UniValue assigned(UniValue::VARR);
+    for (const auto i : values)
+        assigned.get_array().push_back(i);
+    assigned.get_array().push_back(0.25);
+    BOOST_CHECK(v.read(UniValue::stringify(assigned)));
+    for (const UniValue *a : {&assigned, &v}) {
+        const auto reals = a->get_array().to_vector<double>();
+        BOOST_CHECK_EQUAL(reals.size(), values.size() + 1);
+        for (size_t i = 0; i < reals.size(); ++i)
+            BOOST_CHECK_EQUAL(reals[i], a->get_array()[i].get_real());
+        std::vector<int64_t> got(values.size() + 1);
+        BOOST_CHECK_EQUAL(a->get_array().to_numbers(got.data(), got.size()), values.size()); // (0.25 is not an integer)
+        got.pop_back();
+        BOOST_CHECK(got == values);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 int main()
@@ -907,5 +2098,23 @@ int main()
     univalue_array();
     univalue_object();
     univalue_readwrite();
+    univalue_document();
+    univalue_memory_resource();
+    univalue_read_in_place();
+    univalue_stream_reader();
+    univalue_sax();
+    univalue_lazy_document();
+    univalue_read_parallel();
+    univalue_lines();
+    univalue_read_file();
+    univalue_read_filtered();
+    univalue_validate();
+    univalue_shape();
+    univalue_binary_numbers();
+    univalue_get_real();
+    univalue_real_format();
+    univalue_get_int();
+    univalue_fixed();
+    univalue_to_vector();
     return 0;
 }
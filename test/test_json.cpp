@@ -1,7 +1,8 @@
 // Test program that can be called by the JSON test suite at
 // https://github.com/nst/JSONTestSuite.
 //
-// It reads JSON input from stdin and exits with code 0 if it can be parsed
+// It reads JSON input from the file given as its argument (which is
+// memory-mapped), or else from stdin, and exits with code 0 if it can be parsed
 // successfully. It also pretty prints the parsed JSON value to stdout.
 // Additionally, it prints some benchmark stats to stderr.
 
@@ -12,7 +13,10 @@
 #include <cstdio>
 #include <iomanip>
 #include <iostream>
+#include <optional>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <type_traits>
 
 int64_t GetTimeMicros()
@@ -25,25 +29,34 @@ int64_t GetTimeMicros()
     return std::chrono::duration<int64_t, std::nano>(Clock::now() - t0).count() / static_cast<int64_t>(1000);
 }
 
-int main()
+int main(int argc, char *argv[])
 {
     UniValue val;
-    std::string str;
+    std::optional<UniValue::MappedFile> file;
+    std::string buf;
     const auto t0 = GetTimeMicros();
-    {
+    if (argc > 1) {
+        try {
+            file.emplace(argv[1]);
+        } catch (const std::runtime_error &e) {
+            std::cerr << e.what() << std::endl;
+            return 2;
+        }
+    } else {
         // read string, 256kb at a time -- this is faster than using slow std::istreambuf, etc
         size_t nread;
         do {
             constexpr size_t chunkSize = 262144;
-            size_t realSz = str.size();
-            str.resize(realSz + chunkSize, '\0');
-            nread = std::fread(str.data() + realSz, 1, chunkSize, stdin);
+            size_t realSz = buf.size();
+            buf.resize(realSz + chunkSize, '\0');
+            nread = std::fread(buf.data() + realSz, 1, chunkSize, stdin);
             realSz += nread;
-            str.resize(realSz);
+            buf.resize(realSz);
         } while (nread > 0 && !std::feof(stdin) && !std::ferror(stdin));
     }
+    const std::string_view str = file ? file->view() : std::string_view{buf};
     const auto t1 = GetTimeMicros();
-    if (std::string::size_type errpos; val.read(str, &errpos)) {
+    if (std::string_view::size_type errpos; val.read(str, &errpos)) {
         const auto t2 = GetTimeMicros();
         auto outStr = UniValue::stringify(val, 1 /* prettyIndent */);
         const auto t3 = GetTimeMicros();
@@ -9,6 +9,7 @@
 
 #include "univalue.h"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstdlib>
@@ -49,16 +50,65 @@ bool runtest(const std::string& filename, const std::string& jdata)
         assert(wantPass || wantFail);
 
         UniValue val;
-        const bool testResult = val.read(jdata);
+        std::string::size_type errpos;
+        const bool testResult = val.read(jdata, &errpos, UniValue::ReadEngine::Tokenizer);
 
         r_assert(testResult == wantPass);
         if (wantRoundTrip) {
             std::string odata = UniValue::stringify(val, wantPrettyRoundTrip ? 4 : 0);
             w_assert(odata == rtrim(jdata));
         }
+
+        // The other engines must agree exactly with the reference engine
+        for (const auto engine : {UniValue::ReadEngine::Default, UniValue::ReadEngine::StructuralIndex}) {
+            UniValue val2;
+            std::string::size_type errpos2;
+            r_assert(val2.read(jdata, &errpos2, engine) == testResult && errpos2 == errpos);
+            r_assert(!testResult || val2 == val);
+        }
+
+        // So must readSax()
+        UniValue::SaxHandler nullHandler;
+        std::string::size_type errpos3;
+        r_assert(UniValue::readSax(jdata, nullHandler, &errpos3) == testResult && errpos3 == errpos);
+
+        // So must validate()
+        r_assert(UniValue::validate(jdata, &errpos3) == testResult && errpos3 == errpos);
+
+        // So must readParallel(), with the top-level members or elements divided among a few threads
+        for (const unsigned threads : {2u, 3u}) {
+            UniValue val3;
+            r_assert(val3.readParallel(jdata, &errpos3, threads) == testResult && errpos3 == errpos);
+            r_assert(!testResult || val3 == val);
+        }
+
+        // So must LazyDocument
+        UniValue::LazyDocument lazy;
+        r_assert(lazy.read(jdata, &errpos3) == testResult && errpos3 == errpos);
+        r_assert(!testResult || lazy.root().materialize() == val);
+
+        // So must the StreamReader, however the input is split into chunks
+        for (const size_t chunkSize : {size_t{1}, size_t{3}, std::max(jdata.size(), size_t{1})}) {
+            UniValue::StreamReader reader;
+            bool ok = true;
+            for (size_t pos = 0; ok && pos < jdata.size(); pos += chunkSize)
+                ok = reader.feed(jdata.data() + pos, std::min(chunkSize, jdata.size() - pos));
+            r_assert((ok && reader.finish()) == testResult && reader.errorPos() == errpos);
+            r_assert(!testResult || *reader == val);
+        }
         return ret;
 }
 
+/// Returns true if all the read engines agree exactly with the reference engine on the result of parsing `json`.
+bool read_engines_agree(const std::string &json)
+{
+    UniValue val, val2;
+    std::string::size_type errpos, errpos2;
+    const bool ok = val.read(json, &errpos, UniValue::ReadEngine::Tokenizer);
+    const bool ok2 = val2.read(json, &errpos2, UniValue::ReadEngine::StructuralIndex);
+    return ok == ok2 && errpos == errpos2 && (!ok || UniValue::stringify(val) == UniValue::stringify(val2));
+}
+
 bool runtest_file(const std::string &basename)
 {
         std::string filename = std::string(JSON_TEST_SRC) + "/" + basename;
@@ -174,21 +224,209 @@ bool unescape_unicode_test()
     return ret;
 }
 
+// Test the (possibly SIMD-accelerated) string scanning at all lengths and buffer alignments, with the first
+// "special" character placed at every possible position within and across scan blocks.
+bool string_scan_test()
+{
+    bool ret = true;
+    UniValue val;
+    std::string storage;
+    for (size_t offset = 0; offset < 64; ++offset) {
+        for (size_t len = 0; len < 100; ++len) {
+            const std::string plain(len, 'x');
+            // build the json at `offset` bytes into the buffer to exercise all (mis)alignments
+            const auto readAt = [&](const std::string &json) {
+                storage.assign(offset, ' ');
+                storage += json;
+                return val.read(storage.c_str() + offset) != nullptr;
+            };
+            f_assert(readAt("\"" + plain + "\"") && val.get_str() == plain);
+            f_assert(readAt("[\"" + plain + "\\n" + plain + "\"]") && val[0].get_str() == plain + "\n" + plain);
+            f_assert(readAt("\"" + plain + "\xc3\xa9" + plain + "\"") && val.get_str() == plain + "\xc3\xa9" + plain);
+            f_assert(!readAt("\"" + plain + "\t" + plain + "\""));
+            f_assert(!readAt("\"" + plain + "\x7f" + plain) && !readAt("\"" + plain));
+        }
+    }
+    return ret;
+}
+
+bool utf8_validation_test()
+{
+    bool ret = true;
+    UniValue val;
+    struct Case { std::string_view bytes; bool valid; };
+    static constexpr Case cases[] = {
+        {"\xc3\xa9", true}, {"\xe2\x82\xac", true}, {"\xf0\x9d\x84\x9e", true}, {"\xef\xbf\xbf", true},
+        {"\xf4\x8f\xbf\xbf", true}, {"\xed\x9f\xbf", true}, {"\xc2\x80", true}, {"\xe0\xa0\x80", true},
+        {"\xf0\x90\x80\x80", true},
+        {"\x80", false}, {"\xbf", false}, {"\xff", false}, {"\xfe", false}, {"\xc3", false}, {"\xe2\x82", false},
+        {"\xf0\x9d\x84", false}, {"\xc3\x28", false}, {"\xe2\x28\xa1", false}, {"\xf0\x28\x8c\xbc", false},
+        {"\xed\xa0\x80", false}, {"\xed\xbf\xbf", false}, {"\xf8\x88\x80\x80\x80", false},
+    };
+    for (const auto & [bytes, valid] : cases) {
+        // place the sequence at every position relative to the SIMD block boundaries, and with both ASCII and
+        // multi-byte neighbours
+        for (size_t prefixLen = 0; prefixLen < 70; ++prefixLen) {
+            for (const std::string_view filler : {"x", "\xc3\xa9"}) {
+                std::string body(prefixLen, 'x');
+                body += bytes;
+                for (size_t i = 0; i < 3; ++i) body += filler;
+                const std::string json = "[\"" + body + "\",\"" + body + "\\n\"]";
+                const bool ok = val.read(json);
+                f_assert(ok == valid);
+                if (ok && valid)
+                    f_assert(val[0].get_str() == body && val[1].get_str() == body + "\n");
+            }
+        }
+    }
+    return ret;
+}
+
+bool escape_test()
+{
+    bool ret = true;
+    const auto referenceEscape = [](std::string_view s) {
+        std::string out = "\"";
+        for (const char c : s) {
+            const auto ch = static_cast<unsigned char>(c);
+            char buf[8];
+            switch (ch) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (ch < 0x20 || ch == 0x7f) {
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", ch);
+                    out += buf;
+                } else {
+                    out += c;
+                }
+            }
+        }
+        return out + "\"";
+    };
+    for (unsigned ch = 0; ch < 0x100; ++ch) {
+        for (size_t len = 0; len < 100; ++len) {
+            std::string s(len, 'a');
+            s += static_cast<char>(ch);
+            s.append(len % 7, 'b');
+            f_assert(UniValue::stringify(UniValue{std::string_view{s}}) == referenceEscape(s));
+        }
+    }
+    return ret;
+}
+
+// Differential test of the StructuralIndex read engine against the reference engine, using randomly mutated JSON
+// which exercises escapes, quotes and tokens straddling the 64-byte blocks of stage 1.
+bool read_engine_test()
+{
+    bool ret = true;
+    const std::string longStr(100, 'x'), slashes(70, '\\');
+    const std::string seeds[] = {
+        R"({"a":[1,2.5e-3,-0,true,false,null,"s"],"b":{"c":{},"d":[]},"e":"\u00e9\n\"x\\"})",
+        "[\"" + longStr + "\\\"" + longStr + "\",\"" + slashes + "\",\"" + slashes + "\\\"\",  12]",
+        "{\"k\" : [ \"" + longStr + "\" , 12345678901234567890 , {\"" + longStr + "\":\"\xc3\xa9\xe2\x82\xac\"} ] }",
+        "  \"bare string\"  ",
+        "-12.5e+3",
+        std::string(512, '[') + std::string(512, ']'),
+    };
+    const char pool[] = {'"', '\\', '{', '}', '[', ']', ':', ',', ' ', '\n', 'a', '0', '-', 'e', '.', 't', 'n', 'f', '\x01',
+                         '\x7f', '\xc3', '\xa9', 'u', '/'};
+    uint32_t rng = 42;
+    const auto next = [&rng](uint32_t n) { rng = rng * 1103515245u + 12345u; return (rng >> 8) % n; };
+    for (const auto &seed : seeds) {
+        f_assert(UniValue().read(seed) && read_engines_agree(seed));
+        for (int i = 0; i < 3000; ++i) {
+            std::string json = seed;
+            for (uint32_t nMutations = 1 + next(3); nMutations && !json.empty(); --nMutations) {
+                const size_t pos = next(json.size());
+                switch (next(3)) {
+                case 0: json[pos] = pool[next(sizeof(pool))]; break;
+                case 1: json.insert(json.begin() + pos, pool[next(sizeof(pool))]); break;
+                case 2: json.erase(pos, 1); break;
+                }
+            }
+            f_assert(read_engines_agree(json));
+        }
+    }
+    return ret;
+}
+
+// Test that length-delimited reads never look past the end of the buffer, by parsing every prefix of a document from
+// a buffer followed by junk that would otherwise change the result.
+bool bounded_read_test()
+{
+    bool ret = true;
+    const std::string docs[] = {
+        R"({"a":[1,-2.5e-3,true,false,null,"s\u00e9\n"],"b":{"c":{},"d":[]},"e":"\"x\\"})",
+        "[\"" + std::string(100, 'x') + "\xc3\xa9\",12345,[\"\\u00\"]]",
+        "  -12.5E+3  ",
+    };
+    for (const auto &doc : docs) {
+        for (const std::string_view junk : {"1", "e5", "\"", "\\", "u0041\"", "]}", "\xa9\"", "ull", "rue", "alse"}) {
+            for (size_t len = 0; len <= doc.size(); ++len) {
+                const std::string prefix = doc.substr(0, len);
+                const std::string buf = prefix + std::string(junk);
+                for (const auto engine : {UniValue::ReadEngine::Tokenizer, UniValue::ReadEngine::StructuralIndex}) {
+                    UniValue val, val2;
+                    const char *errpos, *errpos2;
+                    const char *ret1 = val.read(prefix.c_str(), &errpos, engine);
+                    const char *ret2 = val2.read(buf.data(), len, &errpos2, engine);
+                    f_assert(!ret1 == !ret2);
+                    f_assert(ret1 ? (ret2 == buf.data() + len && val == val2)
+                                  : (errpos2 - buf.data() == errpos - prefix.c_str()));
+                }
+            }
+        }
+    }
+    return ret;
+}
+
 } // namespace
 
 int main()
 {
-    for (std::size_t fidx = 0; fidx < std::size(filenames); ++fidx) {
-        const auto & fname = filenames[fidx];
-        std::cerr << "Running test on \"" << fname << "\" ... " << std::flush;
-        if (runtest_file(fname)) std::cerr << "OK" << std::endl;
+    // Run all the tests with every kernel implementation supported by this CPU
+    for (const auto & impl : UniValue::simdImplementations()) {
+        assert(UniValue::setSimdImplementation(impl));
+        std::cerr << "--- Using SIMD implementation \"" << UniValue::simdImplementation() << "\" ---" << std::endl;
+
+        for (std::size_t fidx = 0; fidx < std::size(filenames); ++fidx) {
+            const auto & fname = filenames[fidx];
+            std::cerr << "Running test on \"" << fname << "\" ... " << std::flush;
+            if (runtest_file(fname)) std::cerr << "OK" << std::endl;
+            else std::cerr << "Failed!" << std::endl;
+        }
+
+        std::cerr << "Running \"unescape_unicode_test\" ... " << std::flush;
+        if (unescape_unicode_test()) std::cerr << "OK" << std::endl;
         else std::cerr << "Failed!" << std::endl;
-    }
 
-    std::cerr << "Running \"unescape_unicode_test\" ... " << std::flush;
-    if (unescape_unicode_test()) std::cerr << "OK" << std::endl;
-    else std::cerr << "Failed!" << std::endl;
+        std::cerr << "Running \"string_scan_test\" ... " << std::flush;
+        if (string_scan_test()) std::cerr << "OK" << std::endl;
+        else std::cerr << "Failed!" << std::endl;
+
+        std::cerr << "Running \"utf8_validation_test\" ... " << std::flush;
+        if (utf8_validation_test()) std::cerr << "OK" << std::endl;
+        else std::cerr << "Failed!" << std::endl;
+
+        std::cerr << "Running \"escape_test\" ... " << std::flush;
+        if (escape_test()) std::cerr << "OK" << std::endl;
+        else std::cerr << "Failed!" << std::endl;
+
+        std::cerr << "Running \"read_engine_test\" ... " << std::flush;
+        if (read_engine_test()) std::cerr << "OK" << std::endl;
+        else std::cerr << "Failed!" << std::endl;
+
+        std::cerr << "Running \"bounded_read_test\" ... " << std::flush;
+        if (bounded_read_test()) std::cerr << "OK" << std::endl;
+        else std::cerr << "Failed!" << std::endl;
+    }
+    assert(!UniValue::setSimdImplementation("bogus"));
 
     return test_failed ? 1 : 0;
 }
-